@@ -0,0 +1,141 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures multi-threaded breadth-first search keeping visited and queued
+// marks per node in byte atomics and in packed atomic flags arrays.
+//
+
+#include "../include/atomic_flags_array.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+class visited;
+class queued;
+
+typedef typed_flags<visited, queued> marks;
+typedef std::chrono::steady_clock clock_type;
+
+struct graph
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> edges;
+};
+
+graph make_graph(size_t nodes, size_t degree)
+{
+    graph g;
+    std::mt19937 gen(1);
+    g.offsets.push_back(0);
+    for (size_t v = 0; v < nodes; ++v) {
+        // Mostly local edges with some long ones, like meshes and social graphs
+        for (size_t k = 0; k < degree; ++k)
+            g.edges.push_back(uint32_t(k % 4 == 0 ? gen() % nodes : (v + 1 + gen() % 64) % nodes));
+        g.offsets.push_back(uint32_t(g.edges.size()));
+    }
+    return g;
+}
+
+// Byte atomic per node, bit 0 is visited and bit 1 is queued
+struct byte_marks
+{
+    explicit byte_marks(size_t n)
+        : data(new std::atomic<uint8_t>[n])
+    {
+        for (size_t i = 0; i < n; ++i)
+            data[i].store(0, std::memory_order_relaxed);
+    }
+
+    bool claim(size_t i)
+    {
+        if (data[i].load(std::memory_order_acquire) & 1)
+            return false;
+        bool const res = !(data[i].fetch_or(1, std::memory_order_acq_rel) & 1);
+        if (res)
+            data[i].fetch_or(2, std::memory_order_relaxed);
+        return res;
+    }
+
+    std::unique_ptr<std::atomic<uint8_t>[]> data;
+};
+
+struct packed_marks
+{
+    packed_marks(size_t n, atomic_flags_layout layout)
+        : array(n, layout)
+    {}
+
+    bool claim(size_t i)
+    {
+        bool const res = !array.test_and_set<visited>(i);
+        if (res)
+            array.fetch_set<queued>(i, std::memory_order_relaxed);
+        return res;
+    }
+
+    atomic_flags_array<marks> array;
+};
+
+template<typename Marks>
+void measure(char const* name, graph const& g, Marks& marks, size_t threads)
+{
+    size_t const nodes = g.offsets.size() - 1;
+    auto const start = clock_type::now();
+    std::vector<uint32_t> frontier{0};
+    marks.claim(0);
+    size_t reached = 1, levels = 0;
+    while (!frontier.empty()) {
+        std::atomic<size_t> next_chunk{0};
+        std::vector<std::vector<uint32_t>> found(threads);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                size_t const chunk = 256;
+                for (size_t first; (first = next_chunk.fetch_add(chunk)) < frontier.size();) {
+                    size_t const last = first + chunk < frontier.size() ? first + chunk : frontier.size();
+                    for (size_t k = first; k < last; ++k) {
+                        uint32_t const v = frontier[k];
+                        for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                            if (marks.claim(g.edges[e]))
+                                found[t].push_back(g.edges[e]);
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+        frontier.clear();
+        for (auto const& f : found)
+            frontier.insert(frontier.end(), f.begin(), f.end());
+        reached += frontier.size();
+        ++levels;
+    }
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-22s %zu threads: %7.1f M edges/s (%zu of %zu nodes, %zu levels)\n",
+                name, threads, g.edges.size() / s / 1e6, reached, nodes, levels);
+}
+
+int main()
+{
+    size_t const nodes = 1 << 22;
+    graph const g = make_graph(nodes, 8);
+    size_t const cores = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    for (size_t threads : {size_t(1), cores < 4 ? size_t(4) : cores}) {
+        byte_marks bytes(nodes);
+        measure("byte atomics", g, bytes, threads);
+        packed_marks dense(nodes, atomic_flags_layout::dense);
+        measure("packed dense", g, dense, threads);
+        packed_marks striped(nodes, atomic_flags_layout::striped);
+        measure("packed striped", g, striped, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Compares event_flags against typed_flags guarded by mutex and condition
+// variable. Every waiter waits for its own flag, producer sets flags in turn.
+// Reports predicate checks per delivered event and mean set-to-wake latency.
+//
+
+#include "../include/event_flags.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+class s0;
+class s1;
+class s2;
+class s3;
+
+typedef std::chrono::steady_clock clock_type;
+
+static constexpr int rounds = 20000;
+static constexpr int waiters = 4;
+
+struct stats
+{
+    std::atomic<long> wakeups{0};
+    std::atomic<long> latency_ns{0};
+    std::atomic<clock_type::rep> stamp{0};
+};
+
+//
+// event_flags based pipeline
+//
+typedef event_flags<s0, s1, s2, s3> events_type;
+
+template<typename T>
+void event_waiter(events_type& ev, stats& st)
+{
+    for (int i = 0; i < rounds / waiters; ++i) {
+        ev.wait<T>([&st](events_type::flags_type f) {
+            st.wakeups.fetch_add(1);
+            return f.test<T>();
+        });
+        st.latency_ns += clock_type::now().time_since_epoch().count() - st.stamp.load();
+        ev.reset<T>();
+    }
+}
+
+template<typename T>
+void event_produce(events_type& ev, stats& st)
+{
+    st.stamp = clock_type::now().time_since_epoch().count();
+    ev.set<T>();
+    while (ev.test<T>())
+        std::this_thread::yield();
+}
+
+//
+// condition variable based pipeline
+//
+typedef typed_flags<s0, s1, s2, s3> flags_type;
+
+struct condvar_events
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    flags_type flags;
+};
+
+template<typename T>
+void condvar_waiter(condvar_events& ev, stats& st)
+{
+    for (int i = 0; i < rounds / waiters; ++i) {
+        std::unique_lock<std::mutex> lock(ev.mutex);
+        ev.cond.wait(lock, [&] {
+            st.wakeups.fetch_add(1);
+            return ev.flags.test<T>();
+        });
+        st.latency_ns += clock_type::now().time_since_epoch().count() - st.stamp.load();
+        ev.flags.reset<T>();
+    }
+}
+
+template<typename T>
+void condvar_produce(condvar_events& ev, stats& st)
+{
+    st.stamp = clock_type::now().time_since_epoch().count();
+    {
+        std::lock_guard<std::mutex> lock(ev.mutex);
+        ev.flags.set<T>();
+    }
+    ev.cond.notify_all();
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(ev.mutex);
+            if (!ev.flags.test<T>())
+                break;
+        }
+        std::this_thread::yield();
+    }
+}
+
+template<typename Ev, typename Run>
+void report(char const* name, Ev& ev, stats& st, Run run)
+{
+    auto const start = clock_type::now();
+    run(ev, st);
+    auto const elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-12s %8.2f checks/event %10.0f ns latency %8.3f s total\n", name,
+                double(st.wakeups) / rounds, double(st.latency_ns) / rounds, elapsed);
+}
+
+int main()
+{
+    events_type events;
+    stats event_stats;
+    report("event_flags", events, event_stats, [](events_type& ev, stats& st) {
+        std::vector<std::thread> threads;
+        threads.emplace_back(event_waiter<s0>, std::ref(ev), std::ref(st));
+        threads.emplace_back(event_waiter<s1>, std::ref(ev), std::ref(st));
+        threads.emplace_back(event_waiter<s2>, std::ref(ev), std::ref(st));
+        threads.emplace_back(event_waiter<s3>, std::ref(ev), std::ref(st));
+        for (int i = 0; i < rounds / waiters; ++i) {
+            event_produce<s0>(ev, st);
+            event_produce<s1>(ev, st);
+            event_produce<s2>(ev, st);
+            event_produce<s3>(ev, st);
+        }
+        for (auto& t : threads)
+            t.join();
+    });
+    condvar_events condvar;
+    stats condvar_stats;
+    report("condvar", condvar, condvar_stats, [](condvar_events& ev, stats& st) {
+        std::vector<std::thread> threads;
+        threads.emplace_back(condvar_waiter<s0>, std::ref(ev), std::ref(st));
+        threads.emplace_back(condvar_waiter<s1>, std::ref(ev), std::ref(st));
+        threads.emplace_back(condvar_waiter<s2>, std::ref(ev), std::ref(st));
+        threads.emplace_back(condvar_waiter<s3>, std::ref(ev), std::ref(st));
+        for (int i = 0; i < rounds / waiters; ++i) {
+            condvar_produce<s0>(ev, st);
+            condvar_produce<s1>(ev, st);
+            condvar_produce<s2>(ev, st);
+            condvar_produce<s3>(ev, st);
+        }
+        for (auto& t : threads)
+            t.join();
+    });
+    return 0;
+}
@@ -0,0 +1,68 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures conversion throughput between array of flags and per-flag
+// bitmaps against the scalar loop testing every flag of every record.
+//
+
+#include "../include/flag_planes.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+typedef decltype(make_flags(std::make_index_sequence<16>{})) flags_type;
+typedef std::chrono::steady_clock clock_type;
+
+template<size_t... I>
+void scalar_transpose(flags_type const* src, size_t n, flag_planes<flags_type>& planes, std::index_sequence<I...>)
+{
+    for (size_t r = 0; r < n; ++r) {
+        auto _ = {0, (planes.plane(I)[r / 64] |= uint64_t(src[r].template test<fl<I>>()) << (r % 64), 0)...};
+        (void)_;
+    }
+}
+
+template<typename Fn>
+void measure(char const* name, size_t bytes, Fn fn)
+{
+    auto const start = clock_type::now();
+    size_t const rounds = 20;
+    for (size_t i = 0; i < rounds; ++i)
+        fn();
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-20s %8.2f GB/s\n", name, double(bytes) * rounds / s / 1e9);
+}
+
+int main()
+{
+    size_t const n = 1 << 22;
+    std::vector<flags_type> records(n), restored(n);
+    std::mt19937_64 gen(1);
+    for (auto& r : records)
+        r = flags_type(gen());
+    flag_planes<flags_type> planes(n);
+    size_t const bytes = n * sizeof(flags_type);
+
+    measure("scalar transpose", bytes, [&] {
+        planes.assign_zeros(n);
+        scalar_transpose(records.data(), n, planes, std::make_index_sequence<16>{});
+    });
+    measure("transpose_to_planes", bytes, [&] {
+        transpose_to_planes(records.data(), n, planes);
+    });
+    measure("gather_from_planes", bytes, [&] {
+        gather_from_planes(planes, restored.data());
+    });
+    return restored == records ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures rank and select latency of directory against linear popcount
+// scan of plane from the first row.
+//
+
+#include "../include/flag_rank_select.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef std::chrono::steady_clock clock_type;
+
+size_t scan_rank(uint64_t const* words, size_t row)
+{
+    size_t res = 0;
+    for (size_t w = 0; w < row / 64; ++w)
+        res += detail::popcount64(words[w]);
+    if (row % 64)
+        res += detail::popcount64(words[row / 64] & ((uint64_t(1) << (row % 64)) - 1));
+    return res;
+}
+
+size_t scan_select(uint64_t const* words, size_t n)
+{
+    for (size_t w = 0;; ++w) {
+        size_t const c = detail::popcount64(words[w]);
+        if (n < c)
+            return w * 64 + detail::select64(words[w], unsigned(n));
+        n -= c;
+    }
+}
+
+template<typename Fn>
+void measure(char const* name, size_t queries, Fn fn)
+{
+    auto const start = clock_type::now();
+    size_t checksum = 0;
+    for (size_t i = 0; i < queries; ++i)
+        checksum += fn(i);
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-20s %10.1f ns/query (%zu)\n", name, s * 1e9 / queries, checksum);
+}
+
+int main()
+{
+    size_t const n = 1 << 26;
+    std::vector<animal> animals(n);
+    std::mt19937_64 gen(1);
+    for (auto& a : animals)
+        a = animal(gen());
+    flag_planes<animal> planes;
+    transpose_to_planes(animals.data(), n, planes);
+    flag_rank_select<animal> index(planes);
+    std::printf("directory overhead %.2f%%\n",
+        100.0 * index.memory_usage() / (planes.stride() * sizeof(uint64_t) * animal::size()));
+
+    size_t const count = index.count<eats_meat>();
+    std::vector<size_t> rows(1 << 16), ranks(1 << 16);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        rows[i] = gen() % n;
+        ranks[i] = gen() % count;
+    }
+    uint64_t const* const words = planes.plane<eats_meat>();
+    measure("scan rank", 1 << 10, [&](size_t i) { return scan_rank(words, rows[i]); });
+    measure("rank", rows.size(), [&](size_t i) { return index.rank<eats_meat>(rows[i]); });
+    measure("scan select", 1 << 10, [&](size_t i) { return scan_select(words, ranks[i]); });
+    measure("select", ranks.size(), [&](size_t i) { return index.select<eats_meat>(ranks[i]); });
+    return 0;
+}
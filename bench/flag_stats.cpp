@@ -0,0 +1,82 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures per-flag and pairwise counting throughput against the scalar
+// loop testing every pair of flags of every record.
+//
+
+#include "../include/flag_stats.hpp"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+constexpr size_t flags = 16;
+typedef decltype(make_flags(std::make_index_sequence<flags>{})) flags_type;
+typedef std::chrono::steady_clock clock_type;
+
+template<size_t... I>
+void scalar_pairs(flags_type const* src, size_t n, uint64_t* matrix, std::index_sequence<I...>)
+{
+    for (size_t r = 0; r < n; ++r) {
+        bool const bits[] = {src[r].template test<fl<I>>()...};
+        for (size_t i = 0; i < flags; ++i)
+            for (size_t j = 0; j < flags; ++j)
+                matrix[i * flags + j] += bits[i] && bits[j];
+    }
+}
+
+template<typename Fn>
+void measure(char const* name, size_t bytes, Fn fn)
+{
+    auto const start = clock_type::now();
+    size_t const rounds = 10;
+    for (size_t i = 0; i < rounds; ++i)
+        fn();
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-24s %8.3f GB/s\n", name, double(bytes) * rounds / s / 1e9);
+}
+
+int main()
+{
+    size_t const n = 1 << 22;
+    std::vector<flags_type> records(n);
+    std::mt19937_64 gen(1);
+    for (auto& r : records)
+        r = flags_type(gen());
+    flag_planes<flags_type> planes;
+    transpose_to_planes(records.data(), n, planes);
+    size_t const bytes = n * sizeof(flags_type);
+
+    std::vector<uint64_t> scalar(flags * flags);
+    uint64_t checksum = 0;
+    measure("scalar pairs", bytes, [&] {
+        std::fill(scalar.begin(), scalar.end(), 0);
+        scalar_pairs(records.data(), n, scalar.data(), std::make_index_sequence<flags>{});
+    });
+    measure("flag_frequencies", bytes, [&] {
+        checksum += flag_frequencies(records.data(), n).count(0);
+    });
+    measure("co_occurrence", bytes, [&] {
+        checksum += co_occurrence(records.data(), n).count(0, 1);
+    });
+    measure("co_occurrence (planes)", bytes, [&] {
+        checksum += co_occurrence(planes).count(0, 1);
+    });
+
+    auto const matrix = co_occurrence(records.data(), n);
+    bool const same = std::equal(scalar.begin(), scalar.end(), matrix.data());
+    std::printf("checksum %llu\n", static_cast<unsigned long long>(checksum));
+    return same ? 0 : 1;
+}
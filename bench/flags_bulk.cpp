@@ -0,0 +1,68 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures bulk merge and predicated update throughput against
+// per-record loops over typed_flags operators.
+//
+
+#include "../include/flags_bulk.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+typedef decltype(make_flags(std::make_index_sequence<24>{})) flags_type;
+typedef std::chrono::steady_clock clock_type;
+
+template<typename Fn>
+void measure(char const* name, size_t bytes, Fn fn)
+{
+    auto const start = clock_type::now();
+    size_t const rounds = 20;
+    for (size_t i = 0; i < rounds; ++i)
+        fn();
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-20s %8.2f GB/s\n", name, double(bytes) * rounds / s / 1e9);
+}
+
+int main()
+{
+    size_t const n = 1 << 22;
+    std::vector<flags_type> dst(n), src(n);
+    std::mt19937_64 gen(1);
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = flags_type(gen());
+        src[i] = flags_type(gen());
+    }
+    size_t const bytes = n * sizeof(flags_type);
+
+    measure("scalar or", bytes, [&] {
+        for (size_t i = 0; i < n; ++i)
+            dst[i] |= src[i];
+    });
+    measure("bitwise_or", bytes, [&] {
+        bitwise_or(dst.data(), src.data(), n);
+    });
+    measure("scalar update", bytes, [&] {
+        for (auto& r : dst) {
+            if (r.all<fl<0>, fl<5>>()) {
+                r.set<fl<7>>();
+                r.reset<fl<20>>();
+            }
+        }
+    });
+    measure("update_where", bytes, [&] {
+        update_where<all_of<fl<0>, fl<5>>>(dst.data(), n, set_flags<fl<7>>{}, reset_flags<fl<20>>{});
+    });
+    return dst[0].test<fl<20>>() && dst[0].all<fl<0>, fl<5>>() ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures scaling of parallel batch operations from one thread
+// to hardware concurrency (or the number given as the first argument).
+//
+
+#include "../include/flags_parallel.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+class eats_meat;
+class eats_grass;
+class has_tail;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef typed_flags<class w0, class w1, class w2, class w3, class w4, class w5, class w6, class w7,
+                    class w8, class w9, class w10, class w11, class w12, class w13, class w14,
+                    class w15, class w16, class w17, class w18, class w19> wide;
+typedef std::chrono::steady_clock clock_type;
+
+size_t volatile sink;
+
+template<typename Fn>
+double measure(Fn fn)
+{
+    auto const start = clock_type::now();
+    size_t const rounds = 10;
+    for (size_t i = 0; i < rounds; ++i)
+        fn();
+    return std::chrono::duration<double>(clock_type::now() - start).count() / rounds;
+}
+
+int main(int argc, char** argv)
+{
+    size_t const max_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    size_t const n = 1 << 24;
+    std::vector<animal> animals(n);
+    std::vector<wide> w(n);
+    std::mt19937_64 gen(1);
+    for (size_t i = 0; i < n; ++i) {
+        animals[i] = animal(gen());
+        w[i] = wide(gen());
+    }
+
+    std::printf("threads      count     filter  reduce_or  histogram   (M records/s)\n");
+    for (size_t threads = 1; threads <= (max_threads ? max_threads : 1); threads *= 2) {
+        thread_pool pool(threads);
+        double const count = measure([&] {
+            sink = parallel_count<all_of<eats_meat, has_tail>>(animals.data(), n, pool);
+        });
+        double const filter = measure([&] {
+            sink = parallel_filter<any_of<class w3, class w17>>(w.data(), n, pool).size();
+        });
+        double const reduce = measure([&] {
+            sink = parallel_reduce_or(w.data(), n, pool).test<class w0>();
+        });
+        double const histogram = measure([&] {
+            sink = parallel_histogram<class w1, class w5, class w9>(w.data(), n, pool)[3];
+        });
+        std::printf("%7zu %10.1f %10.1f %10.1f %10.1f\n", threads,
+                    n / count / 1e6, n / filter / 1e6, n / reduce / 1e6, n / histogram / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures top-k similarity search over profiles of 200 flags against
+// the loop comparing every flag of every record.
+//
+
+#include "../include/flags_similarity.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+constexpr size_t flags = 200;
+typedef decltype(make_flags(std::make_index_sequence<flags>{})) flags_type;
+typedef std::chrono::steady_clock clock_type;
+
+template<size_t... I>
+size_t per_flag_hamming(flags_type const& a, flags_type const& b, std::index_sequence<I...>)
+{
+    size_t res = 0;
+    auto _ = {0, (res += a.template test<fl<I>>() != b.template test<fl<I>>(), 0)...};
+    (void)_;
+    return res;
+}
+
+template<typename Fn>
+void measure(char const* name, size_t records, Fn fn)
+{
+    auto const start = clock_type::now();
+    size_t const best = fn();
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-24s %8.1f M records/s (best %zu)\n", name, records / s / 1e6, best);
+}
+
+int main()
+{
+    size_t const n = 1 << 20, k = 10;
+    std::vector<flags_type> records(n);
+    std::mt19937 gen(1);
+    for (auto& r : records) {
+        std::string bits;
+        for (size_t i = 0; i < flags; ++i)
+            bits += gen() % 8 == 0 ? '1' : '0';
+        r = flags_type(bits.c_str());
+    }
+    flags_type const query = records[n / 2];
+
+    measure("per-flag hamming", n, [&] {
+        size_t best = 0, distance = flags + 1;
+        for (size_t i = 0; i < n; ++i) {
+            size_t const d = per_flag_hamming(query, records[i], std::make_index_sequence<flags>{});
+            if (d < distance) {
+                distance = d;
+                best = i;
+            }
+        }
+        return best;
+    });
+    measure("top_k hamming", n, [&] {
+        return top_k_similar<hamming_metric>(query, records.data(), n, k)[0].index;
+    });
+    measure("top_k jaccard", n, [&] {
+        return top_k_similar<jaccard_metric>(query, records.data(), n, k)[0].index;
+    });
+    measure("top_k jaccard (subset)", n, [&] {
+        return top_k_similar<jaccard_metric, fl<0>, fl<50>, fl<100>, fl<150>>(query, records.data(), n, k)[0].index;
+    });
+    return 0;
+}
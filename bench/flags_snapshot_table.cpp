@@ -0,0 +1,95 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures reader latency of snapshot acquisition plus typed queries
+// with idle writer and with writer committing batches continuously.
+//
+
+#include "../include/flags_snapshot_table.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+class beta;
+class premium;
+class dark_mode;
+
+typedef typed_flags<beta, premium, dark_mode> features;
+typedef flags_snapshot_table<features> feature_table;
+typedef std::chrono::steady_clock clock_type;
+
+static constexpr size_t rows = 1 << 20;
+static constexpr size_t samples = 200000;
+static constexpr size_t reader_threads = 2;
+
+void run(char const* name, bool with_writer)
+{
+    feature_table table(rows);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> commits{0};
+    std::thread writer;
+    if (with_writer) {
+        writer = std::thread([&] {
+            std::mt19937 gen(1);
+            while (!done.load()) {
+                auto upd = table.begin_update();
+                for (int i = 0; i < 64; ++i) {
+                    size_t const row = gen() % rows;
+                    if (i % 2)
+                        upd.set<premium, beta>(row);
+                    else
+                        upd.reset<premium>(row);
+                }
+                upd.commit();
+                ++commits;
+            }
+        });
+    }
+    std::vector<std::vector<double>> latency(reader_threads);
+    std::vector<std::thread> readers;
+    std::atomic<size_t> hits{0};
+    for (size_t t = 0; t < reader_threads; ++t) {
+        readers.emplace_back([&, t] {
+            auto r = table.make_reader();
+            std::mt19937 gen(t + 2);
+            size_t local = 0;
+            for (size_t i = 0; i < samples; ++i) {
+                size_t const row = gen() % rows;
+                auto const start = clock_type::now();
+                {
+                    auto snap = r.acquire();
+                    local += snap.all<premium, beta>(row) + snap.test<dark_mode>(row);
+                }
+                latency[t].push_back(std::chrono::duration<double, std::nano>(
+                    clock_type::now() - start).count());
+            }
+            hits += local;
+        });
+    }
+    for (auto& t : readers)
+        t.join();
+    done = true;
+    if (writer.joinable())
+        writer.join();
+    std::vector<double> all;
+    for (auto& l : latency)
+        all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    std::printf("%-14s p50 %6.0f ns  p99 %6.0f ns  p99.9 %7.0f ns  commits %zu\n", name,
+                all[all.size() / 2], all[all.size() * 99 / 100], all[all.size() * 999 / 1000],
+                commits.load());
+}
+
+int main()
+{
+    run("idle writer", false);
+    run("busy writer", true);
+    return 0;
+}
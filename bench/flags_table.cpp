@@ -0,0 +1,77 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures update throughput of counted table by number of counter shards
+// and counting latency against a full scan of rows.
+//
+
+#include "../include/flags_table.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef std::chrono::steady_clock clock_type;
+
+double seconds_since(clock_type::time_point start)
+{
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+void measure_updates(size_t shards, size_t threads)
+{
+    size_t const rows = 1 << 20, updates = 1 << 22;
+    flags_table<animal> table(rows, shards);
+    auto const start = clock_type::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&table, t, threads] {
+            std::mt19937 g(static_cast<unsigned>(t));
+            for (size_t i = 0; i < updates / threads; ++i) {
+                size_t const row = g() % (rows / threads) * threads + t;
+                table.assign(row, animal(g()));
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    std::printf("updates, %2zu shards %2zu threads %8.1f M/s\n", shards, threads, updates / seconds_since(start) / 1e6);
+}
+
+int main()
+{
+    size_t const threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    measure_updates(1, threads);
+    measure_updates(threads, threads);
+
+    size_t const rows = 1 << 22;
+    std::vector<animal> init(rows);
+    std::mt19937_64 gen(1);
+    for (auto& r : init)
+        r = animal(gen());
+    flags_table<animal> table(init);
+
+    auto start = clock_type::now();
+    size_t scanned = 0;
+    for (size_t r = 0; r < rows; ++r)
+        scanned += table[r].test<eats_meat>() && !table[r].test<eats_grass>();
+    std::printf("scan                  %12.1f us\n", seconds_since(start) * 1e6);
+
+    start = clock_type::now();
+    size_t const rounds = 1000;
+    size_t counted = 0;
+    for (size_t i = 0; i < rounds; ++i)
+        counted += table.count_combination<all_of<eats_meat>, none_of<eats_grass>>();
+    std::printf("count_combination     %12.1f ns\n", seconds_since(start) * 1e9 / rounds);
+    return counted == scanned * rounds ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures producers modifying central table under lock against pushing
+// modifications to update queue merged by consumer before applying.
+// Events are generated before measuring. Merging costs one probe of a
+// flat table per event, which is cheaper than a locked apply even with
+// bare map updates (cost 0). Larger apply cost stands in for index
+// maintenance or logging and widens the gap, since the queue applies at
+// most a tenth of the events. Lock contention on several cores widens it
+// further. Usage: bench_flags_update_queue [cost]
+//
+
+#include "../include/flags_update_queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace tfl;
+
+class online;
+class banned;
+class premium;
+class dirty;
+
+typedef typed_flags<online, banned, premium, dirty> account;
+typedef flags_update_queue<uint64_t, account> account_queue;
+typedef std::chrono::steady_clock clock_type;
+
+constexpr size_t events = 1 << 21, keys = 1 << 12;
+
+// Keeps apply work from being optimized out
+volatile uint64_t sink;
+
+struct event
+{
+    uint64_t key;
+    account_queue::update value;
+};
+
+typedef std::vector<std::vector<event>> event_streams;
+
+// Events of every thread are generated before measuring, hot keys receive most of them
+event_streams generate(size_t threads)
+{
+    event_streams res(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        std::mt19937 gen(static_cast<unsigned>(t));
+        std::geometric_distribution<uint64_t> key(4.0 / keys);
+        for (size_t i = 0; i < events / threads; ++i) {
+            uint64_t const k = key(gen) % keys;
+            if (i % 2)
+                res[t].push_back({k, account_queue::update::of(set_flags<online, dirty>{})});
+            else
+                res[t].push_back({k, account_queue::update::of(set_flags<premium>{}, reset_flags<online>{})});
+        }
+    }
+    return res;
+}
+
+// Every apply also does cost rounds of mixing, standing in for index
+// maintenance or change logging done per stored modification
+struct central_table
+{
+    explicit central_table(unsigned cost)
+        : cost(cost)
+    {}
+
+    void apply(uint64_t k, account_queue::update const& u)
+    {
+        u.apply(rows[k]);
+        for (unsigned i = 0; i < cost; ++i) {
+            checksum ^= k + i;
+            checksum *= 0x9e3779b97f4a7c15ULL;
+            checksum ^= checksum >> 29;
+        }
+        ++applies;
+    }
+
+    std::unordered_map<uint64_t, account> rows;
+    unsigned cost;
+    uint64_t checksum = 0;
+    size_t applies = 0;
+};
+
+void report(char const* name, size_t threads, clock_type::time_point start, central_table const& table)
+{
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    sink = table.checksum;
+    std::printf("%-14s %zu threads, cost %2u: %6.1f M events/s, %zu applies\n",
+                name, threads, table.cost, events / s / 1e6, table.applies);
+}
+
+void measure_locked(event_streams const& streams, unsigned cost)
+{
+    size_t const threads = streams.size();
+    central_table table(cost);
+    std::mutex lock;
+    auto const start = clock_type::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (auto const& e : streams[t]) {
+                std::lock_guard<std::mutex> guard(lock);
+                table.apply(e.key, e.value);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    report("locked table", threads, start, table);
+}
+
+void measure_queue(event_streams const& streams, unsigned cost)
+{
+    size_t const threads = streams.size();
+    // Only the consumer touches the table, so it needs no lock
+    central_table table(cost);
+    account_queue queue(1 << 16);
+    std::atomic<size_t> done{0};
+    auto const start = clock_type::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            auto p = queue.make_producer();
+            for (auto const& e : streams[t])
+                p.push(e.key, e.value);
+            done.fetch_add(1);
+        });
+    }
+    auto const apply = [&](uint64_t k, account_queue::update const& u) { table.apply(k, u); };
+    // Draining once per flush interval lets modifications of hot keys pile up
+    for (bool last = false; !last;) {
+        last = done.load() == threads;
+        queue.drain(apply);
+        if (!last)
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    for (auto& w : workers)
+        w.join();
+    report("update queue", threads, start, table);
+}
+
+int main(int argc, char** argv)
+{
+    size_t const cores = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    std::vector<unsigned> costs{0, 64};
+    if (argc > 1)
+        costs.assign(1, static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)));
+    for (size_t threads : {size_t(1), cores < 4 ? size_t(4) : cores}) {
+        auto const streams = generate(threads);
+        for (unsigned cost : costs) {
+            measure_locked(streams, cost);
+            measure_queue(streams, cost);
+        }
+    }
+    return 0;
+}
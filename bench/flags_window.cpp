@@ -0,0 +1,54 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures single-threaded ingest rate of sliding window aggregator with
+// 60 one-second buckets and one event per microsecond of event time.
+//
+
+#include "../include/flags_window.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+typedef std::chrono::steady_clock clock_type;
+
+template<size_t Flags>
+void measure(char const* name)
+{
+    typedef decltype(make_flags(std::make_index_sequence<Flags>{})) flags_type;
+    size_t const n = 1 << 24;
+    std::vector<flags_type> events(1 << 16);
+    std::mt19937_64 gen(1);
+    for (auto& e : events)
+        e = flags_type(gen() & gen());
+
+    flags_window<flags_type, 60> window(std::chrono::seconds(1));
+    uint64_t checksum = 0;
+    auto const start = clock_type::now();
+    for (size_t i = 0; i < n; ++i) {
+        window.add(clock_type::time_point(std::chrono::microseconds(i)), events[i & (events.size() - 1)]);
+        if ((i & 0xFFFF) == 0)
+            checksum += window.template count<fl<0>>() + window.template seen_any<fl<1>, fl<Flags - 1>>();
+    }
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-12s %8.1f M events/s (%llu)\n", name, n / s / 1e6, static_cast<unsigned long long>(checksum));
+}
+
+int main()
+{
+    measure<8>("8 flags");
+    measure<16>("16 flags");
+    measure<32>("32 flags");
+    return 0;
+}
@@ -0,0 +1,100 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Measures lookup of access rules whose required flags are held by user,
+// scanning all rules against querying subset index.
+//
+
+#include "../include/subset_index.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+constexpr size_t flags = 128;
+typedef decltype(make_flags(std::make_index_sequence<flags>{})) flags_type;
+typedef std::chrono::steady_clock clock_type;
+
+template<typename Fn>
+void measure(char const* name, size_t queries, Fn fn)
+{
+    auto const start = clock_type::now();
+    size_t const found = fn();
+    double const s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-24s %10.1f queries/s (found %zu)\n", name, queries / s, found);
+}
+
+int main()
+{
+    size_t const rules_count = 300000, queries = 2000;
+    std::mt19937 gen(1);
+    std::vector<flags_type> rules(rules_count), users(queries);
+    auto const random_index = [&] {
+        // Low indices are required more often
+        return size_t(std::min(flags - 1.0, std::exponential_distribution<>(1.0 / 24)(gen)));
+    };
+    for (auto& r : rules) {
+        for (size_t k = 1 + gen() % 4; k > 0; --k)
+            detail::storage_access::data(r)[random_index() / 8] |= uint8_t(1 << (gen() % 8));
+    }
+    for (auto& u : users) {
+        for (size_t k = 16 + gen() % 24; k > 0; --k) {
+            size_t const i = random_index();
+            detail::storage_access::data(u)[i / 8] |= uint8_t(1 << (i % 8));
+        }
+    }
+
+    auto const start = clock_type::now();
+    subset_index<flags_type> index(rules);
+    std::printf("index built in %.1f ms, %zu bytes\n",
+                std::chrono::duration<double, std::milli>(clock_type::now() - start).count(), index.memory_usage());
+
+    measure("linear (rule & user)", queries, [&] {
+        size_t found = 0;
+        for (auto const& u : users) {
+            for (auto const& r : rules)
+                found += (r & u) == r;
+        }
+        return found;
+    });
+    measure("linear is_subset_of", queries, [&] {
+        size_t found = 0;
+        for (auto const& u : users) {
+            for (auto const& r : rules)
+                found += r.is_subset_of(u);
+        }
+        return found;
+    });
+    measure("index subsets", queries, [&] {
+        size_t found = 0;
+        for (auto const& u : users)
+            index.for_each_subset_of(u, [&](size_t) { ++found; });
+        return found;
+    });
+    measure("linear is_superset_of", queries, [&] {
+        size_t found = 0;
+        for (size_t q = 0; q < queries; ++q) {
+            for (auto const& r : rules)
+                found += r.is_superset_of(rules[q]);
+        }
+        return found;
+    });
+    measure("index supersets", queries, [&] {
+        size_t found = 0;
+        for (size_t q = 0; q < queries; ++q)
+            index.for_each_superset_of(rules[q], [&](size_t) { ++found; });
+        return found;
+    });
+    return 0;
+}
@@ -0,0 +1,94 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+// Writes and scans flags files:
+//   flags_scan write <file> <records>   appends random animals
+//   flags_scan count <file> [threads]   counts animals having all<eats_meat, has_tail>
+//
+
+#include "../include/flags_file.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+class eats_meat;
+class eats_grass;
+class has_tail;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+// Files are checked against flag names, files of other flags are rejected
+namespace tfl
+{
+template<> struct flag_name<eats_meat> { static char const* value() noexcept { return "eats_meat"; } };
+template<> struct flag_name<eats_grass> { static char const* value() noexcept { return "eats_grass"; } };
+template<> struct flag_name<has_tail> { static char const* value() noexcept { return "has_tail"; } };
+}
+
+int write(char const* path, size_t n)
+{
+    flags_file_writer<animal> writer(path);
+    std::mt19937_64 gen(std::random_device{}());
+    std::vector<animal> chunk(1 << 16);
+    for (size_t done = 0; done < n; done += chunk.size()) {
+        size_t const count = n - done < chunk.size() ? n - done : chunk.size();
+        for (size_t i = 0; i < count; ++i)
+            chunk[i] = animal(gen());
+        writer.append(chunk.data(), count);
+    }
+    writer.flush();
+    std::printf("%zu records\n", writer.size());
+    return 0;
+}
+
+int count(char const* path, size_t threads)
+{
+    auto const start = std::chrono::steady_clock::now();
+    // opening maps the file, nothing is read until blocks are scanned
+    flags_file_reader<animal> file(path);
+    file.advise_sequential();
+
+    // disjoint block ranges are scanned in parallel
+    std::vector<size_t> counts(threads);
+    std::vector<std::thread> workers;
+    size_t const blocks = file.block_count();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            counts[t] = file.count<all_of<eats_meat, has_tail>>(blocks * t / threads, blocks * (t + 1) / threads);
+        });
+    }
+    size_t total = 0;
+    for (size_t t = 0; t < threads; ++t) {
+        workers[t].join();
+        total += counts[t];
+    }
+    double const ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%zu of %zu records match all<eats_meat, has_tail> (%.1f ms)\n", total, file.size(), ms);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try {
+        if (argc == 4 && std::strcmp(argv[1], "write") == 0)
+            return write(argv[2], std::strtoull(argv[3], nullptr, 10));
+        if ((argc == 3 || argc == 4) && std::strcmp(argv[1], "count") == 0) {
+            size_t const threads = argc == 4 ? std::strtoull(argv[3], nullptr, 10) : std::thread::hardware_concurrency();
+            return count(argv[2], threads ? threads : 1);
+        }
+    }
+    catch (std::exception const& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    std::fprintf(stderr, "usage: %s write <file> <records>\n       %s count <file> [threads]\n", argv[0], argv[0]);
+    return 2;
+}
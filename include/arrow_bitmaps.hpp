@@ -0,0 +1,258 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_ARROW_BITMAPS_HPP_
+#define _TFL_ARROW_BITMAPS_HPP_
+
+#include "typed_flags.hpp"
+#include "flag_planes.hpp"
+#include "flags_query.hpp"
+#include "detail/bits.hpp"
+#include <array>
+#include <stdexcept>
+
+namespace tfl
+{
+
+//!
+//! @brief Boolean bitmap in Apache Arrow buffer layout.
+//!
+//! Value i is bit (offset + i) % 8 of byte (offset + i) / 8, counting
+//! from the least significant bit. Bitmaps exported by the library start
+//! at arrow_alignment boundary and are zero padded to arrow_buffer_bytes().
+//!
+struct arrow_bitmap
+{
+    uint8_t const* data;    //!< buffer holding at least (offset + length + 7) / 8 bytes
+    size_t length;          //!< number of values
+    size_t offset;          //!< bit index of the first value
+};
+
+//!
+//! Alignment and padding of exported buffers in bytes.
+//!
+constexpr size_t arrow_alignment = 64;
+
+//!
+//! Get the size of padded buffer holding bitmap of length values.
+//! @param length number of values.
+//!
+constexpr size_t arrow_buffer_bytes(size_t length) noexcept
+{
+    return (length + arrow_alignment * 8 - 1) / (arrow_alignment * 8) * arrow_alignment;
+}
+
+namespace detail
+{
+
+//
+// Loads up to 64 bits starting at any bit position, touching only bytes
+// holding them. Bits above count are zeros.
+//
+inline uint64_t load_bits(uint8_t const* data, size_t first, size_t count) noexcept
+{
+    if (count == 0)
+        return 0;
+    uint8_t const* const src = data + first / 8;
+    size_t const shift = first % 8;
+    size_t const bytes = (shift + count + 7) / 8;
+    uint64_t res = load_le(src, bytes < 8 ? bytes : 8) >> shift;
+    if (bytes > 8)
+        res |= uint64_t(src[8]) << (64 - shift);
+    return count < 64 ? res & ((uint64_t(1) << count) - 1) : res;
+}
+
+} // namespace detail
+
+//! @name Arrow export
+//! @relates flag_planes
+//! @{
+
+//!
+//! Returns bitmap of the specified flag without copying. Records are
+//! converted to planes by transpose_to_planes(), every plane already has
+//! Arrow layout, alignment and padding.
+//! @param T flag type.
+//! @param planes per-flag bitmaps, must outlive the result.
+//!
+template<typename T, typename... Args>
+arrow_bitmap to_arrow_bitmap(flag_planes<typed_flags<Args...>> const& planes) noexcept
+{
+    return {reinterpret_cast<uint8_t const*>(planes.template plane<T>()), planes.size(), 0};
+}
+
+//!
+//! Returns bitmaps of all flags in index order without copying.
+//! @param planes per-flag bitmaps, must outlive the result.
+//!
+template<typename... Args>
+std::array<arrow_bitmap, sizeof...(Args)> to_arrow_bitmaps(flag_planes<typed_flags<Args...>> const& planes) noexcept
+{
+    return {{to_arrow_bitmap<Args>(planes)...}};
+}
+
+//! @}
+
+template<typename Flags>
+class arrow_flags_view;
+
+//!
+//! @brief Read-only view of flags stored as Arrow bitmaps, one per flag.
+//!
+//! Bitmaps are accessed in place, they may start at any bit offset and
+//! need no alignment. The view doesn't own bitmaps.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class arrow_flags_view<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Creates view of bitmaps listed in flag index order.
+    //! @param bitmaps bitmap of every flag.
+    //! @throws std::invalid_argument if bitmaps have different lengths or no data.
+    //!
+    explicit arrow_flags_view(std::array<arrow_bitmap, sizeof...(Args)> const& bitmaps)
+        : m_bitmaps(bitmaps), m_size(bitmaps.empty() ? 0 : bitmaps[0].length)
+    {
+        for (auto const& b : m_bitmaps) {
+            if (b.length != m_size)
+                throw std::invalid_argument("Arrow bitmaps have different lengths");
+            if (b.data == nullptr && b.length != 0)
+                throw std::invalid_argument("Arrow bitmap has no data");
+        }
+    }
+
+    //!
+    //! Creates view of planes.
+    //! @param planes per-flag bitmaps, must outlive the view.
+    //!
+    explicit arrow_flags_view(flag_planes<flags_type> const& planes)
+        : m_bitmaps(to_arrow_bitmaps(planes)), m_size(planes.size())
+    {}
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Get the number of records.
+    //!
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    //!
+    //! Returns bitmap of flag.
+    //! @param index flag index.
+    //!
+    arrow_bitmap const& bitmap(size_t index) const noexcept
+    {
+        return m_bitmaps[index];
+    }
+
+    //!
+    //! Returns bitmap of the specified flag.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    arrow_bitmap const& bitmap() const noexcept
+    {
+        return bitmap(flags_type::template index<T>());
+    }
+
+    //!
+    //! Returns the value of the specified flag of the record.
+    //! @param T flag type.
+    //! @param row record index less than size().
+    //!
+    template<typename T>
+    bool test(size_t row) const noexcept
+    {
+        auto const& b = bitmap<T>();
+        size_t const bit = b.offset + row;
+        return (b.data[bit / 8] >> (bit % 8)) & 1;
+    }
+
+    //!
+    //! Returns flags of the record.
+    //! @param row record index less than size().
+    //!
+    flags_type get(size_t row) const noexcept
+    {
+        flags_type res;
+        uint8_t* const dst = detail::storage_access::data(res);
+        for (size_t k = 0; k < sizeof...(Args); ++k) {
+            size_t const bit = m_bitmaps[k].offset + row;
+            dst[k / 8] |= uint8_t(((m_bitmaps[k].data[bit / 8] >> (bit % 8)) & 1) << (k % 8));
+        }
+        return res;
+    }
+
+    //!
+    //! Copies records to array of flags.
+    //! @param dst array of at least size() records.
+    //!
+    void decode_into(flags_type* dst) const noexcept
+    {
+        auto const raw = reinterpret_cast<uint8_t*>(dst);
+        uint64_t words[sizeof...(Args) + 1];
+        for (size_t first = 0; first < m_size; first += 64) {
+            size_t const rows = m_size - first < 64 ? m_size - first : 64;
+            for (size_t k = 0; k < sizeof...(Args); ++k)
+                words[k] = detail::load_bits(m_bitmaps[k].data, m_bitmaps[k].offset + first, rows);
+            detail::untranspose_rows<flags_type>(words, rows, raw + first * sizeof(flags_type));
+        }
+    }
+
+    //! @}
+    //! @name Counting
+    //! @{
+
+    //!
+    //! Get the number of records matching predicate.
+    //! @param Pred predicate: all_of, any_of or none_of.
+    //!
+    template<typename Pred>
+    size_t count() const noexcept
+    {
+        typedef detail::list_indices<flags_type, Pred> list;
+        auto const indices = list::get();
+        uint64_t const invert = Pred::inverted ? ~uint64_t(0) : 0;
+        size_t res = 0;
+        for (size_t first = 0; first < m_size; first += 64) {
+            size_t const rows = m_size - first < 64 ? m_size - first : 64;
+            uint64_t match = Pred::conjunctive ? ~uint64_t(0) : 0;
+            for (size_t i = 0; i < list::size; ++i) {
+                auto const& b = m_bitmaps[indices[i]];
+                uint64_t const w = detail::load_bits(b.data, b.offset + first, rows) ^ invert;
+                match = Pred::conjunctive ? (match & w) : (match | w);
+            }
+            if (rows < 64)
+                match &= (uint64_t(1) << rows) - 1;
+            res += detail::popcount64(match);
+        }
+        return res;
+    }
+
+    //! @}
+
+private:
+
+    std::array<arrow_bitmap, sizeof...(Args)> m_bitmaps;
+    size_t m_size;
+};
+
+} // namespace tfl
+
+#endif
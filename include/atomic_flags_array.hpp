@@ -0,0 +1,328 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_ATOMIC_FLAGS_ARRAY_HPP_
+#define _TFL_ATOMIC_FLAGS_ARRAY_HPP_
+
+#include "typed_flags.hpp"
+#include "flags_query.hpp"
+#include "detail/aligned_words.hpp"
+#include "detail/bits.hpp"
+#include <atomic>
+#include <new>
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "Atomic flags array requires lock-free 64-bit atomics"
+#endif
+
+namespace tfl
+{
+
+//!
+//! @brief Placement of atomic flags array elements in memory.
+//!
+enum class atomic_flags_layout
+{
+    dense,      //!< consecutive elements share words
+    striped     //!< consecutive elements are spread over different cache lines
+};
+
+template<typename Flags>
+class atomic_flags_array;
+
+//!
+//! @brief Array of flags modified concurrently by atomic operations.
+//!
+//! Every element takes the power of two bits not less than the number of
+//! flags and never crosses 64-bit word boundary, so modifications are single
+//! atomic operations on the containing word. Striped layout places
+//! neighbouring elements on stripe_lines different cache lines, which keeps
+//! threads processing adjacent elements from contending for one line.
+//! Words are std::atomic objects constructed in cache line aligned storage,
+//! or plain words accessed through std::atomic_ref where it is available.
+//! @param Args... user defined types, at most 64.
+//!
+template<typename... Args>
+class atomic_flags_array<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    static_assert(sizeof...(Args) > 0, "Atomic flags array requires at least one flag");
+    static_assert(sizeof...(Args) <= 64, "Atomic flags array element must fit 64-bit word");
+
+    //!
+    //! Number of bits taken by element.
+    //!
+    static constexpr size_t element_bits = sizeof...(Args) <= 1 ? 1
+                                         : sizeof...(Args) <= 2 ? 2
+                                         : sizeof...(Args) <= 4 ? 4
+                                         : sizeof...(Args) <= 8 ? 8
+                                         : sizeof...(Args) <= 16 ? 16
+                                         : sizeof...(Args) <= 32 ? 32 : 64;
+
+    //!
+    //! Number of cache lines consecutive elements are spread over in striped layout.
+    //!
+    static constexpr size_t stripe_lines = 8;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Creates array with all flags unset.
+    //! @param size number of elements.
+    //! @param layout placement of elements (optional).
+    //!
+    explicit atomic_flags_array(size_t size, atomic_flags_layout layout = atomic_flags_layout::dense)
+        : m_size(size), m_layout(layout),
+          m_words(layout == atomic_flags_layout::dense
+                  ? (size + per_word - 1) / per_word
+                  : (size + per_stripe - 1) / per_stripe * stripe_lines * line_words)
+    {
+#if !defined(__cpp_lib_atomic_ref)
+        // Zero-initialized atomics start the lifetime of words accessed atomically
+        if (m_words.size())
+            m_atomics = ::new (static_cast<void*>(m_words.data())) std::atomic<uint64_t>[m_words.size()]();
+#endif
+    }
+
+    atomic_flags_array(atomic_flags_array const&) = delete;
+    atomic_flags_array& operator = (atomic_flags_array const&) = delete;
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Get the number of elements.
+    //!
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    //!
+    //! Get the placement of elements.
+    //!
+    atomic_flags_layout layout() const noexcept
+    {
+        return m_layout;
+    }
+
+    //!
+    //! Returns the value of the specified flag of the element.
+    //! @param T flag type.
+    //! @param i element index less than size().
+    //! @param order memory order of load (optional).
+    //!
+    template<typename T>
+    bool test(size_t i, std::memory_order order = std::memory_order_acquire) const noexcept
+    {
+        size_t const s = slot(i);
+        return (word(s).load(order) >> (s % per_word * element_bits + flags_type::template index<T>())) & 1;
+    }
+
+    //!
+    //! Returns flags of the element.
+    //! @param i element index less than size().
+    //! @param order memory order of load (optional).
+    //!
+    flags_type get(size_t i, std::memory_order order = std::memory_order_acquire) const noexcept
+    {
+        size_t const s = slot(i);
+        return to_flags(word(s).load(order) >> (s % per_word * element_bits));
+    }
+
+    //!
+    //! Copies elements by relaxed loads, concurrent modifications may be seen partially.
+    //! @param first index of the first element.
+    //! @param n number of elements, first + n must not exceed size().
+    //! @param dst array of at least n flags.
+    //!
+    void load(size_t first, size_t n, flags_type* dst) const noexcept
+    {
+        if (m_layout == atomic_flags_layout::dense) {
+            // Every word is loaded once for all its elements
+            size_t i = first;
+            while (i < first + n) {
+                uint64_t w = word_at(i / per_word).load(std::memory_order_relaxed) >> (i % per_word * element_bits);
+                for (size_t k = i % per_word; k < per_word && i < first + n; ++k, ++i, w = shift_out(w))
+                    *dst++ = to_flags(w);
+            }
+            return;
+        }
+        for (size_t i = first; i < first + n; ++i)
+            *dst++ = get(i, std::memory_order_relaxed);
+    }
+
+    //!
+    //! Get the number of elements having the specified flag set by relaxed loads.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    size_t count() const noexcept
+    {
+        uint64_t const mask = repeat(uint64_t(1) << flags_type::template index<T>());
+        size_t res = 0;
+        for (size_t w = 0; w < m_words.size(); ++w)
+            res += detail::popcount64(word_at(w).load(std::memory_order_relaxed) & mask);
+        return res;
+    }
+
+    //! @}
+    //! @name Modifiers
+    //! @{
+
+    //!
+    //! Sets the specified flag of the element.
+    //! @param T flag type.
+    //! @param i element index less than size().
+    //! @param order memory order of modification (optional).
+    //! @returns previous value of the flag.
+    //!
+    template<typename T>
+    bool test_and_set(size_t i, std::memory_order order = std::memory_order_acq_rel) noexcept
+    {
+        size_t const s = slot(i);
+        uint64_t const bit = uint64_t(1) << (s % per_word * element_bits + flags_type::template index<T>());
+        word_ref w = word(s);
+        // Flag set already doesn't need exclusive ownership of cache line
+        if (w.load(order == std::memory_order_relaxed ? order : std::memory_order_acquire) & bit)
+            return true;
+        return (w.fetch_or(bit, order) & bit) != 0;
+    }
+
+    //!
+    //! Sets specified flags of the element.
+    //! @param T... flag types.
+    //! @param i element index less than size().
+    //! @param order memory order of modification (optional).
+    //! @returns previous flags of the element.
+    //!
+    template<typename... T>
+    flags_type fetch_set(size_t i, std::memory_order order = std::memory_order_acq_rel) noexcept
+    {
+        size_t const s = slot(i);
+        unsigned const shift = unsigned(s % per_word * element_bits);
+        return to_flags(word(s).fetch_or(mask<T...>() << shift, order) >> shift);
+    }
+
+    //!
+    //! Unsets specified flags of the element.
+    //! @param T... flag types.
+    //! @param i element index less than size().
+    //! @param order memory order of modification (optional).
+    //! @returns previous flags of the element.
+    //!
+    template<typename... T>
+    flags_type fetch_reset(size_t i, std::memory_order order = std::memory_order_acq_rel) noexcept
+    {
+        size_t const s = slot(i);
+        unsigned const shift = unsigned(s % per_word * element_bits);
+        return to_flags(word(s).fetch_and(~(mask<T...>() << shift), order) >> shift);
+    }
+
+    //!
+    //! Unsets all flags of all elements, must not run concurrently with other operations.
+    //!
+    void clear() noexcept
+    {
+        for (size_t w = 0; w < m_words.size(); ++w)
+            word_at(w).store(0, std::memory_order_relaxed);
+    }
+
+    //! @}
+
+private:
+
+    static constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    static constexpr size_t per_word = 64 / element_bits;
+    static constexpr size_t line_words = detail::aligned_words::alignment / sizeof(uint64_t);
+    static constexpr size_t per_line = line_words * per_word;
+    static constexpr size_t per_stripe = stripe_lines * per_line;
+    static constexpr uint64_t flag_bits = sizeof...(Args) == 64 ? ~uint64_t(0) : (uint64_t(1) << sizeof...(Args)) - 1;
+
+#if defined(__cpp_lib_atomic_ref)
+    typedef std::atomic_ref<uint64_t> word_ref;
+
+    static_assert(std::atomic_ref<uint64_t>::is_always_lock_free, "Atomic flags words must be lock-free");
+    static_assert(std::atomic_ref<uint64_t>::required_alignment <= detail::aligned_words::alignment,
+                  "Atomic flags words must be aligned by storage");
+#else
+    typedef std::atomic<uint64_t>& word_ref;
+
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Atomic flags words must be plain 64-bit words");
+    static_assert(alignof(std::atomic<uint64_t>) <= detail::aligned_words::alignment,
+                  "Atomic flags words must be aligned by storage");
+#if defined(__cpp_lib_atomic_is_always_lock_free)
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Atomic flags words must be lock-free");
+#endif
+#endif
+
+    // Position of element in the sequence of word slots
+    size_t slot(size_t i) const noexcept
+    {
+        if (m_layout == atomic_flags_layout::dense)
+            return i;
+        size_t const j = i % per_stripe;
+        return i - j + j % stripe_lines * per_line + j / stripe_lines;
+    }
+
+    word_ref word_at(size_t w) const noexcept
+    {
+#if defined(__cpp_lib_atomic_ref)
+        return word_ref(const_cast<uint64_t&>(m_words.data()[w]));
+#else
+        return m_atomics[w];
+#endif
+    }
+
+    word_ref word(size_t slot) const noexcept
+    {
+        return word_at(slot / per_word);
+    }
+
+    static uint64_t shift_out(uint64_t w) noexcept
+    {
+        return element_bits == 64 ? 0 : w >> (element_bits % 64);
+    }
+
+    // Copies element bits of word to every element position
+    static uint64_t repeat(uint64_t bits) noexcept
+    {
+        uint64_t res = 0;
+        for (size_t k = 0; k < per_word; ++k)
+            res |= bits << (k * element_bits);
+        return res;
+    }
+
+    template<typename... T>
+    static uint64_t mask() noexcept
+    {
+        auto const m = detail::flags_mask<flags_type, T...>();
+        return detail::load_le(detail::storage_access::data(m), bytes);
+    }
+
+    static flags_type to_flags(uint64_t bits) noexcept
+    {
+        flags_type res{uninitialized};
+        detail::store_le(detail::storage_access::data(res), bits & flag_bits, bytes);
+        return res;
+    }
+
+    size_t m_size;
+    atomic_flags_layout m_layout;
+    detail::aligned_words m_words;
+#if !defined(__cpp_lib_atomic_ref)
+    std::atomic<uint64_t>* m_atomics = nullptr;
+#endif
+};
+
+} // namespace tfl
+
+#endif
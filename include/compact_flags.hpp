@@ -0,0 +1,470 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_COMPACT_FLAGS_HPP_
+#define _TFL_COMPACT_FLAGS_HPP_
+
+#include "typed_flags.hpp"
+#include "detail/bits.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace tfl
+{
+
+//!
+//! @brief Layouts of compact flags encoding, stored in the first byte.
+//!
+enum class compact_format: uint8_t
+{
+    dense   = 0,    //!< storage bytes as is
+    indices = 1,    //!< varint number of set flags followed by varint gaps between their indexes
+    runs    = 2     //!< varint number of runs followed by their varint lengths, starting with unset run
+};
+
+namespace detail
+{
+
+inline size_t varint_size(uint64_t v) noexcept
+{
+    size_t res = 1;
+    for (; v >= 0x80; v >>= 7)
+        ++res;
+    return res;
+}
+
+//
+// Calls fn with positions where bit value differs from the previous one,
+// bit before the first one is treated as unset. Bits at or above size are ignored.
+//
+template<typename Fn>
+void for_each_boundary(uint8_t const* data, size_t bytes, size_t size, Fn&& fn)
+{
+    uint64_t carry = 0;
+    for (size_t offset = 0; offset < bytes; offset += 8) {
+        size_t const n = bytes - offset < 8 ? bytes - offset : 8;
+        uint64_t const x = load_le(data + offset, n);
+        uint64_t t = x ^ ((x << 1) | carry);
+        carry = x >> 63;
+        if (size - offset * 8 < 64)
+            t &= (uint64_t(1) << (size - offset * 8)) - 1;
+        for (; t != 0; t &= t - 1)
+            fn(offset * 8 + ctz64(t));
+    }
+}
+
+//
+// Sets bits [from, to) of zeroed storage.
+//
+inline void set_bit_range(uint8_t* data, size_t from, size_t to) noexcept
+{
+    if (from >= to)
+        return;
+    for (; from < to && from % 8 != 0; ++from)
+        data[from / 8] |= uint8_t(1u << (from % 8));
+    if (to - from >= 8) {
+        memset(data + from / 8, 0xFF, (to - from) / 8);
+        from += (to - from) / 8 * 8;
+    }
+    for (; from < to; ++from)
+        data[from / 8] |= uint8_t(1u << (from % 8));
+}
+
+} // namespace detail
+
+template<typename Flags>
+class compact_flags_view;
+
+//!
+//! @brief Read-only view of typed flags in compact encoding.
+//!
+//! Queries run on the encoded bytes without expanding them, so sparse
+//! flags are checked by scanning a few varints instead of the whole storage.
+//! Encoding is produced by encode_compact and validated on view creation.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class compact_flags_view<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Parses encoding at the start of buffer.
+    //! @param data encoding start.
+    //! @param size number of bytes available, encoding may be followed by other data.
+    //! @throws std::invalid_argument if encoding is malformed or doesn't match flags type.
+    //!
+    compact_flags_view(uint8_t const* data, size_t size)
+        : m_data(data)
+    {
+        if (size == 0)
+            throw std::invalid_argument("Compact flags encoding is empty");
+        uint8_t const* it = data + 1;
+        uint8_t const* const end = data + size;
+        switch (compact_format(*data)) {
+        case compact_format::dense:
+            if (size_t(end - it) < bytes)
+                throw std::invalid_argument("Compact flags encoding truncated");
+            if (flags_type::size() % 8 != 0 && (it[bytes - 1] >> (flags_type::size() % 8)) != 0)
+                throw std::invalid_argument("Compact flags encoding has padding bits set");
+            it += bytes;
+            break;
+        case compact_format::indices: {
+            uint64_t const count = detail::get_varint(it, end);
+            uint64_t pos = 0;
+            for (uint64_t k = 0; k < count; ++k) {
+                // Compared before adding, huge gap would wrap around
+                uint64_t const gap = detail::get_varint(it, end);
+                if (gap >= flags_type::size() - pos)
+                    throw std::invalid_argument("Compact flags index out of range");
+                pos += gap + 1;
+            }
+            break;
+        }
+        case compact_format::runs: {
+            uint64_t const count = detail::get_varint(it, end);
+            uint64_t pos = 0;
+            for (uint64_t k = 0; k < count; ++k) {
+                uint64_t const len = detail::get_varint(it, end);
+                if (len > flags_type::size() - pos)
+                    throw std::invalid_argument("Compact flags run out of range");
+                pos += len;
+            }
+            break;
+        }
+        default:
+            throw std::invalid_argument("Unknown compact flags format");
+        }
+        m_size = size_t(it - data);
+    }
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Returns the encoding layout.
+    //!
+    compact_format format() const noexcept
+    {
+        return compact_format(*m_data);
+    }
+
+    //!
+    //! Get the number of encoding bytes.
+    //!
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    //!
+    //! Returns the value of the specified flag.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    bool test() const noexcept
+    {
+        return test_bit(flags_type::template index<T>());
+    }
+
+    //!
+    //! Checks that every specified flag is unset.
+    //! @param T... flag types.
+    //! @note Invoking none() without template parameters checks all flags are equal to zero.
+    //!
+    template<typename... T>
+    bool none() const noexcept
+    {
+        if (sizeof...(T) == 0)
+            return count() == 0;
+        size_t const index[] = {flags_type::template index<T>()..., 0};
+        for (size_t i = 0; i < sizeof...(T); ++i) {
+            if (test_bit(index[i]))
+                return false;
+        }
+        return true;
+    }
+
+    //!
+    //! Checks that at least one of specified flags is set.
+    //! @param T... flag types.
+    //! @note Invoking any() without template parameters checks at least one of all flags is set.
+    //!
+    template<typename... T>
+    bool any() const noexcept
+    {
+        return !none<T...>();
+    }
+
+    //!
+    //! Checks that every specified flag is set.
+    //! @param T... flag types.
+    //! @note Invoking all() without template parameters checks all flags are set.
+    //!
+    template<typename... T>
+    bool all() const noexcept
+    {
+        if (sizeof...(T) == 0)
+            return count() == flags_type::size();
+        size_t const index[] = {flags_type::template index<T>()..., 0};
+        for (size_t i = 0; i < sizeof...(T); ++i) {
+            if (!test_bit(index[i]))
+                return false;
+        }
+        return true;
+    }
+
+    //!
+    //! Get the number of set flags.
+    //!
+    size_t count() const noexcept
+    {
+        uint8_t const* it = m_data + 1;
+        switch (format()) {
+        case compact_format::dense: {
+            size_t res = 0;
+            for (size_t offset = 0; offset < bytes; offset += 8)
+                res += detail::popcount64(detail::load_le(it + offset, bytes - offset < 8 ? bytes - offset : 8));
+            return res;
+        }
+        case compact_format::indices:
+            return size_t(next(it));
+        default: {
+            size_t res = 0;
+            size_t pos = 0;
+            uint64_t const count = next(it);
+            for (uint64_t k = 0; k < count; ++k) {
+                size_t const len = size_t(next(it));
+                if (k % 2 != 0)
+                    res += len;
+                pos += len;
+            }
+            return count % 2 != 0 ? res + flags_type::size() - pos : res;
+        }
+        }
+    }
+
+    //! @}
+    //! @name Decoding
+    //! @{
+
+    //!
+    //! Expands encoding into flags, previous values are overwritten.
+    //! @param flags destination.
+    //!
+    void decode_into(flags_type& flags) const noexcept
+    {
+        uint8_t* const dst = detail::storage_access::data(flags);
+        uint8_t const* it = m_data + 1;
+        if (format() == compact_format::dense) {
+            memcpy(dst, it, bytes);
+            return;
+        }
+        memset(dst, 0, bytes);
+        if (format() == compact_format::indices) {
+            size_t pos = 0;
+            for (uint64_t k = next(it); k > 0; --k) {
+                pos += size_t(next(it));
+                dst[pos / 8] |= uint8_t(1u << (pos % 8));
+                ++pos;
+            }
+            return;
+        }
+        size_t pos = 0;
+        uint64_t const count = next(it);
+        for (uint64_t k = 0; k < count; ++k) {
+            size_t const len = size_t(next(it));
+            if (k % 2 != 0)
+                detail::set_bit_range(dst, pos, pos + len);
+            pos += len;
+        }
+        if (count % 2 != 0)
+            detail::set_bit_range(dst, pos, flags_type::size());
+    }
+
+    //!
+    //! Returns expanded flags.
+    //!
+    flags_type decode() const noexcept
+    {
+        flags_type res{uninitialized};
+        decode_into(res);
+        return res;
+    }
+
+    //! @}
+
+private:
+
+    static constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+
+    // Encoding is validated by constructor
+    uint64_t next(uint8_t const*& it) const noexcept
+    {
+        uint64_t res = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            uint8_t const b = *it++;
+            res |= uint64_t(b & 0x7F) << shift;
+            if ((b & 0x80) == 0)
+                return res;
+        }
+    }
+
+    bool test_bit(size_t index) const noexcept
+    {
+        uint8_t const* it = m_data + 1;
+        switch (format()) {
+        case compact_format::dense:
+            return (it[index / 8] >> (index % 8)) & 1;
+        case compact_format::indices: {
+            size_t pos = 0;
+            for (uint64_t k = next(it); k > 0; --k) {
+                pos += size_t(next(it));
+                if (pos >= index)
+                    return pos == index;
+                ++pos;
+            }
+            return false;
+        }
+        default: {
+            size_t pos = 0;
+            uint64_t const count = next(it);
+            for (uint64_t k = 0; k < count; ++k) {
+                pos += size_t(next(it));
+                if (pos > index)
+                    return k % 2 != 0;
+            }
+            return count % 2 != 0;
+        }
+        }
+    }
+
+    uint8_t const* m_data;
+    size_t m_size;
+};
+
+//! @name Compact encoding
+//! @{
+
+//!
+//! Appends compact encoding of flags.<br> Layout is chosen by the number of set
+//! flags and value changes: few set flags are stored as index gaps, few long
+//! runs as run lengths, everything else as storage bytes.
+//! @param flags value to encode.
+//! @param out buffer to append encoding to.
+//! @returns number of bytes appended.
+//!
+template<typename... Args>
+size_t encode_compact(typed_flags<Args...> const& flags, std::vector<uint8_t>& out)
+{
+    typedef typed_flags<Args...> flags_type;
+    constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    constexpr size_t size = flags_type::size();
+    uint8_t const* const data = detail::storage_access::data(flags);
+
+    size_t set = 0;
+    size_t boundaries = 0;
+    uint64_t carry = 0;
+    for (size_t offset = 0; offset < bytes; offset += 8) {
+        size_t const n = bytes - offset < 8 ? bytes - offset : 8;
+        uint64_t const x = detail::load_le(data + offset, n);
+        set += detail::popcount64(x);
+        boundaries += detail::popcount64(x ^ ((x << 1) | carry));
+        carry = x >> 63;
+    }
+    // trailing padding doesn't start a run
+    if (size != 0 && ((data[(size - 1) / 8] >> ((size - 1) % 8)) & 1) && size % 64 != 0)
+        --boundaries;
+
+    // lower bounds are checked before exact sizes to keep dense flags cheap
+    size_t best = bytes;
+    compact_format format = compact_format::dense;
+    if (set + 1 < best) {
+        size_t len = detail::varint_size(set);
+        size_t prev = 0;
+        detail::for_each_set_bit(data, bytes, [&](size_t pos) {
+            len += detail::varint_size(pos - prev);
+            prev = pos + 1;
+        });
+        if (len < best) {
+            best = len;
+            format = compact_format::indices;
+        }
+    }
+    if (boundaries + 1 < best) {
+        size_t len = 0;
+        size_t count = 0;
+        size_t prev = 0;
+        detail::for_each_boundary(data, bytes, size, [&](size_t pos) {
+            len += detail::varint_size(pos - prev);
+            prev = pos;
+            ++count;
+        });
+        len += detail::varint_size(count);
+        if (len < best) {
+            best = len;
+            format = compact_format::runs;
+        }
+    }
+
+    size_t const start = out.size();
+    out.push_back(uint8_t(format));
+    switch (format) {
+    case compact_format::dense:
+        out.insert(out.end(), data, data + bytes);
+        break;
+    case compact_format::indices: {
+        detail::put_varint(out, set);
+        size_t prev = 0;
+        detail::for_each_set_bit(data, bytes, [&](size_t pos) {
+            detail::put_varint(out, pos - prev);
+            prev = pos + 1;
+        });
+        break;
+    }
+    case compact_format::runs: {
+        size_t count = 0;
+        detail::for_each_boundary(data, bytes, size, [&](size_t) { ++count; });
+        detail::put_varint(out, count);
+        size_t prev = 0;
+        detail::for_each_boundary(data, bytes, size, [&](size_t pos) {
+            detail::put_varint(out, pos - prev);
+            prev = pos;
+        });
+        break;
+    }
+    }
+    return out.size() - start;
+}
+
+//!
+//! Expands compact encoding into flags.
+//! @param data encoding start.
+//! @param size number of bytes available.
+//! @param flags destination.
+//! @returns number of bytes consumed.
+//! @throws std::invalid_argument if encoding is malformed or doesn't match flags type.
+//!
+template<typename... Args>
+size_t decode_compact(uint8_t const* data, size_t size, typed_flags<Args...>& flags)
+{
+    compact_flags_view<typed_flags<Args...>> view(data, size);
+    view.decode_into(flags);
+    return view.size();
+}
+
+//! @}
+
+} // namespace tfl
+
+#endif
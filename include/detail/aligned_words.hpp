@@ -0,0 +1,101 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_ALIGNED_WORDS_HPP_
+#define _TFL_ALIGNED_WORDS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace tfl
+{
+namespace detail
+{
+
+//
+// Zero-initialized array of 64-bit words starting at cache line boundary.
+//
+class aligned_words
+{
+public:
+
+    static constexpr size_t alignment = 64;
+
+    aligned_words() noexcept
+        : m_raw(nullptr), m_data(nullptr), m_size(0)
+    {}
+
+    explicit aligned_words(size_t n)
+        : m_raw(nullptr), m_data(nullptr), m_size(n)
+    {
+        if (n == 0)
+            return;
+        m_raw = ::operator new(n * sizeof(uint64_t) + alignment);
+        auto const addr = reinterpret_cast<uintptr_t>(m_raw);
+        m_data = reinterpret_cast<uint64_t*>((addr + alignment - 1) & ~uintptr_t(alignment - 1));
+        memset(m_data, 0, n * sizeof(uint64_t));
+    }
+
+    aligned_words(aligned_words const& other)
+        : aligned_words(other.m_size)
+    {
+        if (m_size)
+            memcpy(m_data, other.m_data, m_size * sizeof(uint64_t));
+    }
+
+    aligned_words(aligned_words&& other) noexcept
+        : aligned_words()
+    {
+        swap(other);
+    }
+
+    aligned_words& operator = (aligned_words other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~aligned_words()
+    {
+        ::operator delete(m_raw);
+    }
+
+    void swap(aligned_words& other) noexcept
+    {
+        std::swap(m_raw, other.m_raw);
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+
+    uint64_t* data() noexcept
+    {
+        return m_data;
+    }
+
+    uint64_t const* data() const noexcept
+    {
+        return m_data;
+    }
+
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+private:
+
+    void* m_raw;
+    uint64_t* m_data;
+    size_t m_size;
+};
+
+} // namespace detail
+} // namespace tfl
+
+#endif
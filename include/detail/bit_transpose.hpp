@@ -0,0 +1,115 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_BIT_TRANSPOSE_HPP_
+#define _TFL_BIT_TRANSPOSE_HPP_
+
+#include "bits.hpp"
+#include <cstddef>
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace tfl
+{
+namespace detail
+{
+
+//
+// Transposes 8x8 bit matrix stored row by row in bytes,
+// bit c of byte r is moved to bit r of byte c.
+//
+inline uint64_t transpose8x8(uint64_t x) noexcept
+{
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+//
+// Transposes 8x8 byte matrix stored in 8 words,
+// byte c of word r is moved to byte r of word c.
+//
+inline void transpose_bytes8x8(uint64_t* w) noexcept
+{
+    auto const swap = [](uint64_t& lo, uint64_t& hi, uint64_t mask, unsigned shift) {
+        uint64_t const l = (lo & mask) | ((hi & mask) << shift);
+        uint64_t const h = ((lo >> shift) & mask) | (hi & ~mask);
+        lo = l;
+        hi = h;
+    };
+    for (size_t k = 0; k < 4; ++k)
+        swap(w[k], w[k + 4], 0x00000000FFFFFFFFULL, 32);
+    for (size_t k : {0, 1, 4, 5})
+        swap(w[k], w[k + 2], 0x0000FFFF0000FFFFULL, 16);
+    for (size_t k : {0, 2, 4, 6})
+        swap(w[k], w[k + 1], 0x00FF00FF00FF00FFULL, 8);
+}
+
+//
+// Splits 64 bytes into 8 words, bit r of word c is bit c of byte r.
+//
+inline void transpose_64x8(uint8_t const* rows, uint64_t* cols) noexcept
+{
+    uint64_t res[8] = {};
+#if defined(__AVX2__)
+    for (size_t h = 0; h < 64; h += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(rows + h));
+        // most significant bit of each byte goes first, adding shifts the next one in
+        auto const next = [&v, h]() {
+            uint64_t const m = uint64_t(uint32_t(_mm256_movemask_epi8(v))) << h;
+            v = _mm256_add_epi8(v, v);
+            return m;
+        };
+        res[7] |= next(); res[6] |= next(); res[5] |= next(); res[4] |= next();
+        res[3] |= next(); res[2] |= next(); res[1] |= next(); res[0] |= next();
+    }
+#elif defined(__SSE2__)
+    for (size_t h = 0; h < 64; h += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(rows + h));
+        // most significant bit of each byte goes first, adding shifts the next one in
+        auto const next = [&v, h]() {
+            uint64_t const m = uint64_t(uint32_t(_mm_movemask_epi8(v))) << h;
+            v = _mm_add_epi8(v, v);
+            return m;
+        };
+        res[7] |= next(); res[6] |= next(); res[5] |= next(); res[4] |= next();
+        res[3] |= next(); res[2] |= next(); res[1] |= next(); res[0] |= next();
+    }
+#else
+    for (size_t g = 0; g < 8; ++g)
+        res[g] = transpose8x8(load_le(rows + g * 8));
+    transpose_bytes8x8(res);
+#endif
+    for (size_t k = 0; k < 8; ++k)
+        cols[k] = res[k];
+}
+
+//
+// Inverse of transpose_64x8, bit c of byte r is bit r of word c.
+//
+inline void transpose_8x64(uint64_t const* cols, uint8_t* rows) noexcept
+{
+    uint64_t x[8];
+    for (size_t k = 0; k < 8; ++k)
+        x[k] = cols[k];
+    transpose_bytes8x8(x);
+    for (size_t g = 0; g < 8; ++g)
+        store_le(rows + g * 8, transpose8x8(x[g]));
+}
+
+} // namespace detail
+} // namespace tfl
+
+#endif
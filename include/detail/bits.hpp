@@ -0,0 +1,186 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_BITS_HPP_
+#define _TFL_BITS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#if defined(__BMI2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace tfl
+{
+namespace detail
+{
+
+//
+// Number of set bits in word.
+//
+inline unsigned popcount64(uint64_t v) noexcept
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_popcountll(v));
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return unsigned((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+//
+// Carry-save adder: sums three words bitwise into high and low bits.
+//
+inline void csa(uint64_t& high, uint64_t& low, uint64_t a, uint64_t b, uint64_t c) noexcept
+{
+    uint64_t const u = a ^ b;
+    high = (a & b) | (u & c);
+    low = u ^ c;
+}
+
+//
+// Number of set bits in 16 words. Harley-Seal carry-save tree
+// reduces 16 popcounts to 5.
+//
+inline uint64_t popcount16(uint64_t const* w) noexcept
+{
+    uint64_t ones = 0, twos = 0, fours = 0, eights = 0, sixteens;
+    uint64_t twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+    csa(twos_a, ones, ones, w[0], w[1]);
+    csa(twos_b, ones, ones, w[2], w[3]);
+    csa(fours_a, twos, twos, twos_a, twos_b);
+    csa(twos_a, ones, ones, w[4], w[5]);
+    csa(twos_b, ones, ones, w[6], w[7]);
+    csa(fours_b, twos, twos, twos_a, twos_b);
+    csa(eights_a, fours, fours, fours_a, fours_b);
+    csa(twos_a, ones, ones, w[8], w[9]);
+    csa(twos_b, ones, ones, w[10], w[11]);
+    csa(fours_a, twos, twos, twos_a, twos_b);
+    csa(twos_a, ones, ones, w[12], w[13]);
+    csa(twos_b, ones, ones, w[14], w[15]);
+    csa(fours_b, twos, twos, twos_a, twos_b);
+    csa(eights_b, fours, fours, fours_a, fours_b);
+    csa(sixteens, eights, eights, eights_a, eights_b);
+    return 16 * uint64_t(popcount64(sixteens)) + 8 * uint64_t(popcount64(eights))
+         + 4 * uint64_t(popcount64(fours)) + 2 * uint64_t(popcount64(twos)) + popcount64(ones);
+}
+
+//
+// Index of the least significant set bit, word must not be zero.
+//
+inline unsigned ctz64(uint64_t v) noexcept
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_ctzll(v));
+#else
+    unsigned n = 0;
+    for (; (v & 1) == 0; v >>= 1)
+        ++n;
+    return n;
+#endif
+}
+
+//
+// Position of the k-th (from zero) set bit of word, k must be less than
+// the number of set bits. BMI2 deposits bit k to its place in one pdep.
+//
+inline unsigned select64(uint64_t v, unsigned k) noexcept
+{
+#if defined(__BMI2__) && defined(__x86_64__)
+    return ctz64(_pdep_u64(uint64_t(1) << k, v));
+#else
+    unsigned shift = 0;
+    for (unsigned c; (c = popcount64(v & 0xFF)) <= k; v >>= 8, shift += 8)
+        k -= c;
+    for (; k; --k)
+        v &= v - 1;
+    return shift + ctz64(v);
+#endif
+}
+
+//
+// Loads up to 8 bytes as little-endian word, missing bytes are zeros.
+// Partial words are assembled from bytes, copying them into a zeroed
+// word would stall on store forwarding when the word is read back.
+//
+inline uint64_t load_le(uint8_t const* src, size_t n = 8) noexcept
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (n == 8) {
+        uint64_t res;
+        memcpy(&res, src, 8);
+        return res;
+    }
+#endif
+    uint64_t res = 0;
+    for (size_t i = 0; i < n; ++i)
+        res |= uint64_t(src[i]) << (i * 8);
+    return res;
+}
+
+//
+// Stores lower n bytes of word in little-endian order.
+//
+inline void store_le(uint8_t* dst, uint64_t v, size_t n = 8) noexcept
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(dst, &v, n);
+#else
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = uint8_t(v >> (i * 8));
+#endif
+}
+
+//
+// Calls fn with positions of set bits in ascending order.
+//
+template<typename Fn>
+void for_each_set_bit(uint8_t const* data, size_t bytes, Fn&& fn)
+{
+    for (size_t offset = 0; offset < bytes; offset += 8) {
+        size_t const n = bytes - offset < 8 ? bytes - offset : 8;
+        for (uint64_t x = load_le(data + offset, n); x != 0; x &= x - 1)
+            fn(offset * 8 + ctz64(x));
+    }
+}
+
+//
+// LEB128 variable length encoding of unsigned numbers.
+//
+inline void put_varint(std::vector<uint8_t>& out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+//
+// Decodes varint advancing src.
+// @throws std::invalid_argument if input is truncated or too long.
+//
+inline uint64_t get_varint(uint8_t const*& src, uint8_t const* end)
+{
+    uint64_t res = 0;
+    for (unsigned shift = 0; src != end && shift < 64; shift += 7) {
+        uint8_t const b = *src++;
+        res |= uint64_t(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+            return res;
+    }
+    throw std::invalid_argument("Malformed varint");
+}
+
+} // namespace detail
+} // namespace tfl
+
+#endif
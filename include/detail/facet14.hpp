@@ -27,47 +27,54 @@ public:
 
     template<typename... T>
     bool none() const noexcept {
+        flags_hook<D>::template on_access<flag_op::query, T...>();
         bool r = true;
-        auto _ = {0, (r = r && !this_().template test<T>(), 0)...};
+        auto _ = {0, (r = r && !this_().get_bit(D::template index<T>()), 0)...};
         (void)_;
         return r;
     }
 
     template<typename... T>
     bool all() const noexcept {
+        flags_hook<D>::template on_access<flag_op::query, T...>();
         bool r = true;
-        auto _ = {0, (r = r &&  this_().template test<T>(), 0)...};
+        auto _ = {0, (r = r &&  this_().get_bit(D::template index<T>()), 0)...};
         (void)_;
         return r;
     }
 
     template<typename... T>
     void set(bool value = true) noexcept {
+        flags_hook<D>::template on_access<flag_op::set, T...>();
         auto _ = {0, (this_().set_bit(D::template index<T>(), value), 0)...};
         (void)_;
     }
 
     template<typename... T>
     void set(flag<T>... flags) noexcept {
+        flags_hook<D>::template on_access<flag_op::set, T...>();
         auto _ = {0, (this_().set_bit(D::template index<T>(), flags), 0)...};
         (void)_;
     }
 
     template<typename... T>
     void get(flag<T>&... flags) const noexcept {
-        auto _ = {0, (flags = this_().template test<T>(), 0)...};
+        flags_hook<D>::template on_access<flag_op::query, T...>();
+        auto _ = {0, (flags = this_().get_bit(D::template index<T>()), 0)...};
         (void)_;
     }
 
     template<typename... T>
     void reset() noexcept {
+        flags_hook<D>::template on_access<flag_op::reset, T...>();
         auto _ = {0, (this_().set_bit(D::template index<T>(), false), 0)...};
         (void)_;
     }
 
     template<typename... T>
     void flip() noexcept {
-        auto _ = {0, (this_().set_bit(D::template index<T>(), !this_().template test<T>()), 0)...};
+        flags_hook<D>::template on_access<flag_op::flip, T...>();
+        auto _ = {0, (this_().set_bit(D::template index<T>(), !this_().get_bit(D::template index<T>())), 0)...};
         (void)_;
     }
 };
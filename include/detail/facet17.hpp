@@ -27,37 +27,44 @@ public:
 
     template<typename... T>
     bool none() const noexcept {
-        return (... && (!this_().template test<T>()));
+        flags_hook<D>::template on_access<flag_op::query, T...>();
+        return (... && (!this_().get_bit(D::template index<T>())));
     }
 
     template<typename... T>
     bool all() const noexcept {
-        return (... && ( this_().template test<T>()));
+        flags_hook<D>::template on_access<flag_op::query, T...>();
+        return (... && ( this_().get_bit(D::template index<T>())));
     }
 
     template<typename... T>
     void set(bool value = true) noexcept {
+        flags_hook<D>::template on_access<flag_op::set, T...>();
         (..., (this_().set_bit(D::template index<T>(), value)));
     }
 
     template<typename... T>
     void set(flag<T>... flags) noexcept {
+        flags_hook<D>::template on_access<flag_op::set, T...>();
         (..., (this_().set_bit(D::template index<T>(), flags)));
     }
 
     template<typename... T>
     void get(flag<T>&... flags) const noexcept {
-        (..., (flags = this_().template test<T>()));
+        flags_hook<D>::template on_access<flag_op::query, T...>();
+        (..., (flags = this_().get_bit(D::template index<T>())));
     }
 
     template<typename... T>
     void reset() noexcept {
+        flags_hook<D>::template on_access<flag_op::reset, T...>();
         (..., (this_().set_bit(D::template index<T>(), false)));
     }
 
     template<typename... T>
     void flip() noexcept {
-        (..., (this_().set_bit(D::template index<T>(), !this_().template test<T>())));
+        flags_hook<D>::template on_access<flag_op::flip, T...>();
+        (..., (this_().set_bit(D::template index<T>(), !this_().get_bit(D::template index<T>()))));
     }
 };
 
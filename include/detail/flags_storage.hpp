@@ -8,6 +8,7 @@
 #define _TFL_FLAGS_STORAGE_HPP_
 
 #include <cstddef>
+#include <cstdint>
 #include <array>
 #include <string>
 #include <cstring>
@@ -16,6 +17,22 @@
 
 namespace tfl
 {
+
+//!
+//! @brief Tag type selecting a constructor which leaves flags uninitialized.
+//!
+//! Useful for bulk arrays whose content is overwritten right after allocation.
+//!
+struct uninitialized_t
+{
+    explicit constexpr uninitialized_t() = default;
+};
+
+//!
+//! Tag value selecting a constructor which leaves flags uninitialized.
+//!
+constexpr uninitialized_t uninitialized{};
+
 namespace detail
 {
 
@@ -73,6 +90,23 @@ public:
         reset();
     }
     
+    explicit flags_storage(uninitialized_t) noexcept
+    {}
+    
+    template<size_t K>
+    flags_storage(std::array<size_t, K> const& index,
+                  std::array<bool, K> const& value) noexcept
+    {
+        // Banks are built in a local copy and stored once
+        std::array<bank_type, bank_count> banks{};
+        for (size_t k = 0; k < K; ++k) {
+            auto const mask = bank_type(1) << (index[k] % bank_bits);
+            auto& bank = banks[index[k] / bank_bits];
+            bank = value[k] ? (bank | mask) : (bank & ~mask);
+        }
+        m_data = banks;
+    }
+    
     explicit flags_storage(unsigned long long data) noexcept
     {
         init<bank_count * sizeof(bank_type)>(data);
@@ -188,12 +222,47 @@ public:
         return m_data == other.m_data;
     }
     
+    // Accumulates excess bits of 64-bit words without branching on each of them
+    bool is_subset(flags_storage<N> const& other) const noexcept
+    {
+        uint64_t excess = 0;
+        size_t k = 0;
+        for (; k + sizeof(uint64_t) <= m_data.size(); k += sizeof(uint64_t)) {
+            uint64_t a, b;
+            memcpy(&a, m_data.data() + k, sizeof(a));
+            memcpy(&b, other.m_data.data() + k, sizeof(b));
+            excess |= a & ~b;
+        }
+        for (; k < m_data.size(); ++k)
+            excess |= uint64_t(m_data[k] & ~other.m_data[k]);
+        return excess == 0;
+    }
+    
     template<typename BinFn>
     void bitwise(flags_storage<N> const& other, BinFn&& fn) noexcept
     {
         std::transform(m_data.begin(), m_data.end(), other.m_data.begin(),
                        m_data.begin(), fn);
     }
+    
+    //
+    // Raw access, bits are packed from the least significant one of the first byte
+    // and unused bits of the last byte are always zeros
+    //
+    static constexpr size_t bytes() noexcept
+    {
+        return bank_count * sizeof(bank_type);
+    }
+    
+    uint8_t const* data() const noexcept
+    {
+        return m_data.data();
+    }
+    
+    uint8_t* data() noexcept
+    {
+        return m_data.data();
+    }
         
 private:
     
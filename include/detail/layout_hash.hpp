@@ -0,0 +1,45 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_LAYOUT_HASH_HPP_
+#define _TFL_LAYOUT_HASH_HPP_
+
+#include "../typed_flags.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace tfl
+{
+namespace detail
+{
+
+constexpr uint64_t fnv1a_prime = 1099511628211ull;
+
+inline uint64_t fnv1a(char const* str, uint64_t hash = 14695981039346656037ull) noexcept
+{
+    for (; *str; ++str)
+        hash = (hash ^ uint8_t(*str)) * fnv1a_prime;
+    return hash;
+}
+
+//
+// Hash of flag names in order. Persistent data checks it to detect data
+// written for other or reordered flags. Names are terminated by zero byte,
+// so splitting one name in two changes the hash.
+//
+template<typename... Args>
+uint64_t layout_hash() noexcept
+{
+    uint64_t hash = (fnv1a("tfl") ^ uint64_t(sizeof...(Args))) * fnv1a_prime;
+    bool const _[] = {true, (hash = fnv1a(flag_name<Args>::value(), hash) * fnv1a_prime, true)...};
+    (void)_;
+    return hash;
+}
+
+} // namespace detail
+} // namespace tfl
+
+#endif
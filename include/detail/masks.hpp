@@ -0,0 +1,38 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_MASKS_HPP_
+#define _TFL_MASKS_HPP_
+
+#include <cstddef>
+
+namespace tfl
+{
+namespace detail
+{
+
+//
+// Builds bit mask of flag types T... inside word number 'word'
+// of the flag sequence of F split into words of type W.
+// Least significant bit of the first word corresponds to the first flag.
+//
+template<typename W, typename F, typename... T>
+constexpr W word_mask(size_t word = 0) noexcept
+{
+    constexpr size_t word_bits = sizeof(W) * 8;
+    size_t const index[] = {F::template index<T>()..., size_t(-1)};
+    W res = 0;
+    for (size_t i = 0; i < sizeof...(T); ++i) {
+        if (index[i] / word_bits == word)
+            res |= W(1) << (index[i] % word_bits);
+    }
+    return res;
+}
+
+} // namespace detail
+} // namespace tfl
+
+#endif
@@ -0,0 +1,77 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_PARTIALS_HPP_
+#define _TFL_PARTIALS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace tfl
+{
+namespace detail
+{
+
+//
+// Per-thread partial results, every one occupies its own cache lines.
+// Aligned manually, over-aligned new is not available before C++17.
+//
+template<typename T>
+class partials
+{
+public:
+
+    static_assert(std::is_trivially_destructible<T>::value, "Partial results are not destroyed");
+
+    explicit partials(size_t n)
+        : partials(n, uninitialized{})
+    {
+        for (size_t i = 0; i < n; ++i)
+            new (m_data + i * stride) T();
+    }
+
+    partials(size_t n, T const& init)
+        : partials(n, uninitialized{})
+    {
+        for (size_t i = 0; i < n; ++i)
+            new (m_data + i * stride) T(init);
+    }
+
+    T& operator [] (size_t i) noexcept
+    {
+        return *reinterpret_cast<T*>(m_data + i * stride);
+    }
+
+    T const& operator [] (size_t i) const noexcept
+    {
+        return *reinterpret_cast<T const*>(m_data + i * stride);
+    }
+
+private:
+
+    static constexpr size_t stride = (sizeof(T) + 63) / 64 * 64;
+
+    struct uninitialized
+    {};
+
+    partials(size_t n, uninitialized)
+        : m_raw(new unsigned char[n * stride + 63])
+    {
+        auto const addr = reinterpret_cast<uintptr_t>(m_raw.get());
+        m_data = m_raw.get() + ((64 - addr % 64) % 64);
+    }
+
+    std::unique_ptr<unsigned char[]> m_raw;
+    unsigned char* m_data;
+};
+
+} // namespace detail
+} // namespace tfl
+
+#endif
@@ -0,0 +1,29 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_POSIX_ERROR_HPP_
+#define _TFL_POSIX_ERROR_HPP_
+
+#include <cerrno>
+#include <system_error>
+
+namespace tfl
+{
+namespace detail
+{
+
+//
+// Reports failed system call by its errno.
+//
+[[noreturn]] inline void throw_errno(char const* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+} // namespace detail
+} // namespace tfl
+
+#endif
@@ -0,0 +1,54 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_VISIT_HPP_
+#define _TFL_VISIT_HPP_
+
+#include "bits.hpp"
+#include <cstddef>
+
+namespace tfl
+{
+namespace detail
+{
+
+//
+// Calls visitor with type_tag of flag type at runtime index.
+//
+template<typename Fn, typename... Args>
+struct type_visitor
+{
+    template<typename T>
+    static void call(Fn& fn)
+    {
+        fn(type_tag<T>{});
+    }
+
+    static void visit(size_t index, Fn& fn)
+    {
+        static constexpr void (*table[])(Fn&) = {&call<Args>..., nullptr};
+        table[index](fn);
+    }
+};
+
+//
+// Calls visitor for each flag type whose bit is set in raw storage bytes.
+// Zero words are skipped, so cost depends on the number of set bits.
+//
+template<typename... Args, typename Fn>
+void visit_set_bits(uint8_t const* data, size_t bytes, Fn& fn)
+{
+    for (size_t offset = 0; offset < bytes; offset += 8) {
+        size_t const n = bytes - offset < 8 ? bytes - offset : 8;
+        for (uint64_t w = load_le(data + offset, n); w != 0; w &= w - 1)
+            type_visitor<Fn, Args...>::visit(offset * 8 + ctz64(w), fn);
+    }
+}
+
+} // namespace detail
+} // namespace tfl
+
+#endif
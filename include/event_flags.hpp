@@ -0,0 +1,379 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_EVENT_FLAGS_HPP_
+#define _TFL_EVENT_FLAGS_HPP_
+
+#include "typed_flags.hpp"
+#include "detail/masks.hpp"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace tfl
+{
+namespace detail
+{
+
+#if defined(__linux__)
+
+//
+// Sleeps while word is equal to expected value until one of bits
+// from bitset is passed to futex_wake or absolute monotonic deadline expires.
+//
+inline void futex_wait(std::atomic<uint32_t> const& word, uint32_t expected,
+                       uint32_t bitset, timespec const* deadline) noexcept
+{
+    static_assert(sizeof(word) == sizeof(uint32_t), "Atomic word is not futex compatible");
+    syscall(SYS_futex, reinterpret_cast<uint32_t const*>(&word),
+            FUTEX_WAIT_BITSET_PRIVATE, expected, deadline, nullptr, bitset);
+}
+
+//
+// Wakes threads sleeping on word with bitset intersecting given one.
+//
+inline void futex_wake(std::atomic<uint32_t> const& word, uint32_t bitset) noexcept
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t const*>(&word),
+            FUTEX_WAKE_BITSET_PRIVATE, INT_MAX, nullptr, nullptr, bitset);
+}
+
+#endif
+
+} // namespace detail
+
+//!
+//! @brief Set of typed flags threads can wait on.
+//!
+//! Flags are stored in a single atomic word. Waiting threads sleep until
+//! flags they wait for are changed, other modifications don't wake them.
+//! On Linux waiting is built on futex bitsets, elsewhere on condition variable.
+//! @param Args... user defined types, at most 32.
+//!
+template<typename... Args>
+class event_flags
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+private:
+
+    typedef uint32_t word_type;
+    typedef std::chrono::steady_clock clock_type;
+
+    static_assert(sizeof...(Args) <= sizeof(word_type) * 8, "Too many flags for event word");
+
+    template<typename... T>
+    static constexpr word_type mask() noexcept
+    {
+        static_assert(sizeof...(T) > 0, "No flags to wait for");
+        return detail::word_mask<word_type, flags_type, T...>();
+    }
+
+    struct all_of_mask
+    {
+        word_type mask;
+        bool operator()(word_type v) const noexcept {
+            return (v & mask) == mask;
+        }
+    };
+
+    struct any_of_mask
+    {
+        word_type mask;
+        bool operator()(word_type v) const noexcept {
+            return (v & mask) != 0;
+        }
+    };
+
+    template<typename Pred>
+    struct flags_pred
+    {
+        Pred& pred;
+        bool operator()(word_type v) const {
+            return pred(flags_type(v));
+        }
+    };
+
+public:
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Sets all flags to zero.
+    //!
+    event_flags() noexcept
+        : m_state(0), m_waiters(0)
+    {}
+
+    //!
+    //! Loads initial flag values.
+    //! @param flags initial values.
+    //!
+    explicit event_flags(flags_type const& flags) noexcept
+        : m_state(flags.template to_integral<word_type>()), m_waiters(0)
+    {}
+
+    event_flags(event_flags const&) = delete;
+    event_flags& operator = (event_flags const&) = delete;
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Returns the value of the specified flag.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    bool test() const noexcept
+    {
+        return (m_state.load() & mask<T>()) != 0;
+    }
+
+    //!
+    //! Checks that every specified flag is set.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    bool all() const noexcept
+    {
+        return all_of_mask{mask<T...>()}(m_state.load());
+    }
+
+    //!
+    //! Checks that at least one of specified flags is set.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    bool any() const noexcept
+    {
+        return any_of_mask{mask<T...>()}(m_state.load());
+    }
+
+    //!
+    //! Returns snapshot of all flags.
+    //!
+    flags_type load() const noexcept
+    {
+        return flags_type(m_state.load());
+    }
+
+    //! @}
+    //! @name Modifiers
+    //! @{
+
+    //!
+    //! Sets specified flags and wakes threads waiting for them.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    void set() noexcept
+    {
+        constexpr word_type bits = mask<T...>();
+        word_type const changed = ~m_state.fetch_or(bits) & bits;
+        if (changed != 0 && m_waiters.load() != 0)
+            notify(changed);
+    }
+
+    //!
+    //! Unsets specified flags.<br> Nobody is woken since waiting
+    //! conditions only require flags to be set.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    void reset() noexcept
+    {
+        m_state.fetch_and(~mask<T...>());
+    }
+
+    //! @}
+    //! @name Waiting
+    //! @{
+
+    //!
+    //! Blocks until every specified flag is set.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    void wait_all() const
+    {
+        constexpr word_type bits = mask<T...>();
+        wait_impl(bits, all_of_mask{bits}, nullptr);
+    }
+
+    //!
+    //! Blocks until at least one of specified flags is set.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    void wait_any() const
+    {
+        constexpr word_type bits = mask<T...>();
+        wait_impl(bits, any_of_mask{bits}, nullptr);
+    }
+
+    //!
+    //! Blocks until predicate is satisfied by flags.<br> Predicate is
+    //! rechecked only when one of specified flags is set.
+    //! @param T... flag types predicate depends on.
+    //! @param pred callable taking flags_type.
+    //! @returns flags satisfying predicate.
+    //!
+    template<typename... T, typename Pred>
+    flags_type wait(Pred pred) const
+    {
+        return flags_type(wait_impl(mask<T...>(), flags_pred<Pred>{pred}, nullptr));
+    }
+
+    //!
+    //! Blocks until every specified flag is set or time point is reached.
+    //! @param T... flag types.
+    //! @param tp time point to wait until.
+    //! @returns true if flags are set, false on timeout.
+    //!
+    template<typename... T, typename Clock, typename Duration>
+    bool wait_all_until(std::chrono::time_point<Clock, Duration> const& tp) const
+    {
+        constexpr word_type bits = mask<T...>();
+        auto const deadline = to_steady(tp);
+        return all_of_mask{bits}(wait_impl(bits, all_of_mask{bits}, &deadline));
+    }
+
+    //!
+    //! Blocks until at least one of specified flags is set or time point is reached.
+    //! @param T... flag types.
+    //! @param tp time point to wait until.
+    //! @returns true if one of flags is set, false on timeout.
+    //!
+    template<typename... T, typename Clock, typename Duration>
+    bool wait_any_until(std::chrono::time_point<Clock, Duration> const& tp) const
+    {
+        constexpr word_type bits = mask<T...>();
+        auto const deadline = to_steady(tp);
+        return any_of_mask{bits}(wait_impl(bits, any_of_mask{bits}, &deadline));
+    }
+
+    //!
+    //! Blocks until every specified flag is set or timeout expires.
+    //! @param T... flag types.
+    //! @param timeout maximum duration to block for.
+    //! @returns true if flags are set, false on timeout.
+    //!
+    template<typename... T, typename Rep, typename Period>
+    bool wait_all_for(std::chrono::duration<Rep, Period> const& timeout) const
+    {
+        return wait_all_until<T...>(clock_type::now() + timeout);
+    }
+
+    //!
+    //! Blocks until at least one of specified flags is set or timeout expires.
+    //! @param T... flag types.
+    //! @param timeout maximum duration to block for.
+    //! @returns true if one of flags is set, false on timeout.
+    //!
+    template<typename... T, typename Rep, typename Period>
+    bool wait_any_for(std::chrono::duration<Rep, Period> const& timeout) const
+    {
+        return wait_any_until<T...>(clock_type::now() + timeout);
+    }
+
+    //! @}
+
+private:
+
+    template<typename Clock, typename Duration>
+    static clock_type::time_point to_steady(std::chrono::time_point<Clock, Duration> const& tp)
+    {
+        return clock_type::now() + std::chrono::duration_cast<clock_type::duration>(tp - Clock::now());
+    }
+
+    static clock_type::time_point to_steady(clock_type::time_point const& tp) noexcept
+    {
+        return tp;
+    }
+
+    //
+    // Waits until check is satisfied and returns the last observed state.
+    // Waiter is registered before reading state, so a concurrent set()
+    // either is observed here or sees the waiter and issues a wakeup.
+    //
+    template<typename Check>
+    word_type wait_impl(word_type bits, Check const& check,
+                        clock_type::time_point const* deadline) const
+    {
+        word_type state = m_state.load();
+        if (check(state))
+            return state;
+        m_waiters.fetch_add(1);
+#if defined(__linux__)
+        timespec ts;
+        timespec const* pts = nullptr;
+        if (deadline) {
+            // steady_clock is CLOCK_MONOTONIC which is what futex bitset wait expects
+            auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline->time_since_epoch()).count();
+            ts.tv_sec = ns / 1000000000;
+            ts.tv_nsec = ns % 1000000000;
+            pts = &ts;
+        }
+        for (state = m_state.load(); !check(state); state = m_state.load()) {
+            if (deadline && clock_type::now() >= *deadline)
+                break;
+            detail::futex_wait(m_state, state, bits, pts);
+        }
+#else
+        (void)bits;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (state = m_state.load(); !check(state); state = m_state.load()) {
+                if (!deadline)
+                    m_cond.wait(lock);
+                else if (m_cond.wait_until(lock, *deadline) == std::cv_status::timeout) {
+                    state = m_state.load();
+                    break;
+                }
+            }
+        }
+#endif
+        m_waiters.fetch_sub(1);
+        return state;
+    }
+
+    void notify(word_type changed) noexcept
+    {
+#if defined(__linux__)
+        detail::futex_wake(m_state, changed);
+#else
+        (void)changed;
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_cond.notify_all();
+#endif
+    }
+
+    std::atomic<word_type> m_state;
+    mutable std::atomic<word_type> m_waiters;
+#if !defined(__linux__)
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_cond;
+#endif
+};
+
+} // namespace tfl
+
+#endif
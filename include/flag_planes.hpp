@@ -0,0 +1,288 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAG_PLANES_HPP_
+#define _TFL_FLAG_PLANES_HPP_
+
+#include "typed_flags.hpp"
+#include "detail/aligned_words.hpp"
+#include "detail/bit_transpose.hpp"
+#include "detail/bits.hpp"
+
+namespace tfl
+{
+
+template<typename Flags>
+class flag_planes;
+
+//!
+//! @brief Column-wise storage of flag arrays, one bitmap per flag.
+//!
+//! Bit r of plane i is the value of flag i in row r, bits are numbered
+//! from the least significant bit of the first 64-bit word. Every plane
+//! starts at 64-byte boundary and is zero padded to a multiple of 64 bytes.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class flag_planes<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //!
+    //! Number of bits in plane word.
+    //!
+    static constexpr size_t word_bits = 64;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Creates empty planes.
+    //!
+    flag_planes() noexcept
+        : m_size(0), m_stride(0)
+    {}
+
+    //!
+    //! Creates planes of rows with all flags set to zero.
+    //! @param rows number of rows.
+    //!
+    explicit flag_planes(size_t rows)
+        : m_size(rows), m_stride(stride_for(rows)), m_words(m_stride * sizeof...(Args))
+    {}
+
+    //! @}
+    //! @name Capacity
+    //! @{
+
+    //!
+    //! Get the number of rows.
+    //!
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    //!
+    //! Get the number of words in every plane including padding.
+    //!
+    size_t stride() const noexcept
+    {
+        return m_stride;
+    }
+
+    //!
+    //! Changes the number of rows, all flags are set to zero.
+    //! @param rows number of rows.
+    //!
+    void assign_zeros(size_t rows)
+    {
+        flag_planes(rows).swap(*this);
+    }
+
+    void swap(flag_planes& other) noexcept
+    {
+        std::swap(m_size, other.m_size);
+        std::swap(m_stride, other.m_stride);
+        m_words.swap(other.m_words);
+    }
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Returns words of plane by flag index.
+    //! @param index flag index less than flags_type::size().
+    //!
+    uint64_t const* plane(size_t index) const noexcept
+    {
+        return m_words.data() + index * m_stride;
+    }
+
+    uint64_t* plane(size_t index) noexcept
+    {
+        return m_words.data() + index * m_stride;
+    }
+
+    //!
+    //! Returns words of plane of the specified flag.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    uint64_t const* plane() const noexcept
+    {
+        return plane(flags_type::template index<T>());
+    }
+
+    //!
+    //! Returns the value of the specified flag in the row.
+    //! @param T flag type.
+    //! @param row row index.
+    //!
+    template<typename T>
+    bool test(size_t row) const noexcept
+    {
+        return (plane<T>()[row / word_bits] >> (row % word_bits)) & 1;
+    }
+
+    //!
+    //! Get the number of rows having the specified flag set.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    size_t count() const noexcept
+    {
+        auto const words = plane<T>();
+        size_t res = 0;
+        for (size_t i = 0, n = (m_size + word_bits - 1) / word_bits; i < n; ++i)
+            res += detail::popcount64(words[i]);
+        return res;
+    }
+
+    //! @}
+
+private:
+
+    // Planes are padded to 64 bytes
+    static size_t stride_for(size_t rows) noexcept
+    {
+        return (rows + 511) / 512 * 8;
+    }
+
+    size_t m_size;
+    size_t m_stride;
+    detail::aligned_words m_words;
+};
+
+namespace detail
+{
+
+//
+// Moves storage bytes of up to 64 records between record-major
+// and byte-major order, missing records are zeros.
+//
+template<typename Flags>
+struct planes_block
+{
+    static constexpr size_t bytes = storage_access::bytes<Flags>();
+    static constexpr size_t stride = sizeof(Flags);
+
+    static void gather(uint8_t const* src, size_t rows, uint8_t (*out)[64]) noexcept
+    {
+        size_t r = 0;
+        for (; r < rows; ++r)
+            for (size_t byte = 0; byte < bytes; ++byte)
+                out[byte][r] = src[r * stride + byte];
+        for (; r < 64; ++r)
+            for (size_t byte = 0; byte < bytes; ++byte)
+                out[byte][r] = 0;
+    }
+
+    static void scatter(uint8_t const (*in)[64], size_t rows, uint8_t* dst) noexcept
+    {
+        for (size_t r = 0; r < rows; ++r)
+            for (size_t byte = 0; byte < bytes; ++byte)
+                dst[r * stride + byte] = in[byte][r];
+    }
+};
+
+//
+// Transposes up to 64 records into one word per flag, missing rows are zeros.
+// Output must have room for all storage bits.
+//
+template<typename Flags>
+void transpose_rows(uint8_t const* src, size_t rows, uint64_t* out) noexcept
+{
+    typedef planes_block<Flags> block;
+    uint8_t columns[block::bytes + 1][64];
+    bool const direct = block::stride == 1 && rows == 64;
+    if (!direct)
+        block::gather(src, rows, columns);
+    for (size_t byte = 0; byte < block::bytes; ++byte)
+        transpose_64x8(direct ? src : columns[byte], out + byte * 8);
+}
+
+//
+// Writes up to 64 records from one word per flag, the inverse of transpose_rows.
+//
+template<typename Flags>
+void untranspose_rows(uint64_t const* words, size_t rows, uint8_t* dst) noexcept
+{
+    typedef planes_block<Flags> block;
+    constexpr size_t flags = Flags::size();
+    uint8_t columns[block::bytes + 1][64];
+    uint64_t group[8];
+    for (size_t byte = 0; byte < block::bytes; ++byte) {
+        for (size_t k = 0; k < 8; ++k)
+            group[k] = byte * 8 + k < flags ? words[byte * 8 + k] : 0;
+        transpose_8x64(group, columns[byte]);
+    }
+    block::scatter(columns, rows, dst);
+}
+
+} // namespace detail
+
+//! @name Plane conversions
+//! @relates flag_planes
+//! @{
+
+//!
+//! Converts array of flags to per-flag bitmaps using 8x8 bit matrix
+//! transposition of storage bytes (SSE2/AVX2 movemask when available).
+//! @param src array of flags.
+//! @param n number of records.
+//! @param planes destination resized to n rows.
+//!
+template<typename... Args>
+void transpose_to_planes(typed_flags<Args...> const* src, size_t n, flag_planes<typed_flags<Args...>>& planes)
+{
+    typedef typed_flags<Args...> flags_type;
+    typedef detail::planes_block<flags_type> block;
+    constexpr size_t flags = sizeof...(Args);
+
+    if (planes.size() != n)
+        planes.assign_zeros(n);
+    auto const raw = reinterpret_cast<uint8_t const*>(src);
+    uint64_t words[block::bytes * 8 + 1];
+    for (size_t b = 0; b * 64 < n; ++b) {
+        size_t const rows = n - b * 64 < 64 ? n - b * 64 : 64;
+        detail::transpose_rows<flags_type>(raw + b * 64 * block::stride, rows, words);
+        for (size_t k = 0; k < flags; ++k)
+            planes.plane(k)[b] = words[k];
+    }
+}
+
+//!
+//! Converts per-flag bitmaps back to array of flags.
+//! @param planes source bitmaps.
+//! @param dst array of at least planes.size() records.
+//!
+template<typename... Args>
+void gather_from_planes(flag_planes<typed_flags<Args...>> const& planes, typed_flags<Args...>* dst)
+{
+    typedef typed_flags<Args...> flags_type;
+    typedef detail::planes_block<flags_type> block;
+    constexpr size_t flags = sizeof...(Args);
+
+    size_t const n = planes.size();
+    auto const raw = reinterpret_cast<uint8_t*>(dst);
+    uint64_t words[flags + 1];
+    for (size_t b = 0; b * 64 < n; ++b) {
+        size_t const rows = n - b * 64 < 64 ? n - b * 64 : 64;
+        for (size_t k = 0; k < flags; ++k)
+            words[k] = planes.plane(k)[b];
+        detail::untranspose_rows<flags_type>(words, rows, raw + b * 64 * block::stride);
+    }
+}
+
+//! @}
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,241 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAG_RANK_SELECT_HPP_
+#define _TFL_FLAG_RANK_SELECT_HPP_
+
+#include "flag_planes.hpp"
+#include "detail/bits.hpp"
+#include <vector>
+
+namespace tfl
+{
+
+template<typename Flags>
+class flag_rank_select;
+
+//!
+//! @brief Rank and select directory over per-flag bitmaps.
+//!
+//! Keeps absolute number of set bits per 65536 rows and relative one per
+//! 512 rows (one cache line of plane), and the block of every 8192-th set
+//! bit as select hint. Directory takes about 4% of plane size, the planes
+//! must outlive it and stay unchanged.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class flag_rank_select<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+    typedef flag_planes<flags_type> planes_type;
+
+    //!
+    //! Number of rows counted by one relative entry.
+    //!
+    static constexpr size_t block_bits = 512;
+
+    //!
+    //! Number of rows counted by one absolute entry.
+    //!
+    static constexpr size_t super_bits = 65536;
+
+    //!
+    //! Number of set bits between select hints.
+    //!
+    static constexpr size_t select_sample = 8192;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Builds directory of all planes.
+    //! @param planes per-flag bitmaps.
+    //!
+    explicit flag_rank_select(planes_type const& planes)
+        : m_planes(&planes),
+          m_blocks(planes.stride() / block_words + 1),
+          m_supers(m_blocks / super_blocks + 1),
+          m_super(m_supers * flags),
+          m_block(m_blocks * flags),
+          m_sample_first(flags + 1)
+    {
+        for (size_t k = 0; k < flags; ++k)
+            build(k);
+        m_sample_first[flags] = m_samples.size();
+    }
+
+    //! @}
+    //! @name Capacity
+    //! @{
+
+    //!
+    //! Get the number of rows.
+    //!
+    size_t size() const noexcept
+    {
+        return m_planes->size();
+    }
+
+    //!
+    //! Get the number of bytes taken by directory.
+    //!
+    size_t memory_usage() const noexcept
+    {
+        return m_super.size() * sizeof(uint64_t) + m_block.size() * sizeof(uint16_t)
+             + m_samples.size() * sizeof(uint64_t) + m_sample_first.size() * sizeof(size_t);
+    }
+
+    //! @}
+    //! @name Queries
+    //! @{
+
+    //!
+    //! Get the number of rows having flag set.
+    //! @param index flag index.
+    //!
+    size_t count(size_t index) const noexcept
+    {
+        return rank(index, size());
+    }
+
+    //!
+    //! Get the number of rows before row having flag set.
+    //! @param index flag index.
+    //! @param row row index not greater than size().
+    //!
+    size_t rank(size_t index, size_t row) const noexcept
+    {
+        uint64_t const* const words = m_planes->plane(index);
+        size_t const block = row / block_bits;
+        size_t res = block_rank(index, block);
+        size_t const last = row / word_bits;
+        for (size_t w = block * block_words; w < last; ++w)
+            res += detail::popcount64(words[w]);
+        if (row % word_bits)
+            res += detail::popcount64(words[last] & ((uint64_t(1) << (row % word_bits)) - 1));
+        return res;
+    }
+
+    //!
+    //! Get the row of the n-th (from zero) row having flag set.
+    //! @param index flag index.
+    //! @param n number of set rows to skip.
+    //! @returns row index or size() if there are no more than n set rows.
+    //!
+    size_t select(size_t index, size_t n) const noexcept
+    {
+        if (n >= count(index))
+            return size();
+        uint64_t const* const samples = m_samples.data() + m_sample_first[index];
+        size_t const sample = n / select_sample;
+        // Last block starting at or before n-th set bit lies between hints
+        size_t lo = samples[sample];
+        size_t hi = sample + 1 < m_sample_first[index + 1] - m_sample_first[index] ? samples[sample + 1] : m_blocks - 1;
+        while (lo < hi) {
+            size_t const mid = lo + (hi - lo + 1) / 2;
+            if (block_rank(index, mid) <= n)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        uint64_t const* const words = m_planes->plane(index) + lo * block_words;
+        size_t rest = n - block_rank(index, lo);
+        for (size_t w = 0;; ++w) {
+            size_t const c = detail::popcount64(words[w]);
+            if (rest < c)
+                return (lo * block_words + w) * word_bits + detail::select64(words[w], unsigned(rest));
+            rest -= c;
+        }
+    }
+
+    //!
+    //! Get the number of rows having the specified flag set.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    size_t count() const noexcept
+    {
+        return count(flags_type::template index<T>());
+    }
+
+    //!
+    //! Get the number of rows before row having the specified flag set.
+    //! @param T flag type.
+    //! @param row row index not greater than size().
+    //!
+    template<typename T>
+    size_t rank(size_t row) const noexcept
+    {
+        return rank(flags_type::template index<T>(), row);
+    }
+
+    //!
+    //! Get the row of the n-th (from zero) row having the specified flag set.
+    //! @param T flag type.
+    //! @param n number of set rows to skip.
+    //! @returns row index or size() if there are no more than n set rows.
+    //!
+    template<typename T>
+    size_t select(size_t n) const noexcept
+    {
+        return select(flags_type::template index<T>(), n);
+    }
+
+    //! @}
+
+private:
+
+    static constexpr size_t flags = sizeof...(Args);
+    static constexpr size_t word_bits = 64;
+    static constexpr size_t block_words = block_bits / word_bits;
+    static constexpr size_t super_blocks = super_bits / block_bits;
+
+    size_t block_rank(size_t index, size_t block) const noexcept
+    {
+        return size_t(m_super[index * m_supers + block / super_blocks]) + m_block[index * m_blocks + block];
+    }
+
+    void build(size_t index)
+    {
+        uint64_t const* const words = m_planes->plane(index);
+        uint64_t* const super = m_super.data() + index * m_supers;
+        uint16_t* const block = m_block.data() + index * m_blocks;
+        m_sample_first[index] = m_samples.size();
+        uint64_t total = 0;
+        size_t relative = 0;
+        for (size_t b = 0; b < m_blocks; ++b) {
+            if (b % super_blocks == 0) {
+                super[b / super_blocks] = total;
+                relative = 0;
+            }
+            block[b] = uint16_t(relative);
+            if (b + 1 == m_blocks)
+                break;
+            size_t ones = 0;
+            for (size_t w = 0; w < block_words; ++w)
+                ones += detail::popcount64(words[b * block_words + w]);
+            // Hint every block holding a multiple of select_sample set bit
+            for (uint64_t next = (total + select_sample - 1) / select_sample * select_sample; next < total + ones; next += select_sample)
+                m_samples.push_back(b);
+            total += ones;
+            relative += ones;
+        }
+    }
+
+    planes_type const* m_planes;
+    size_t m_blocks;
+    size_t m_supers;
+    std::vector<uint64_t> m_super;
+    std::vector<uint16_t> m_block;
+    std::vector<uint64_t> m_samples;
+    std::vector<size_t> m_sample_first;
+};
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,320 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAG_STATS_HPP_
+#define _TFL_FLAG_STATS_HPP_
+
+#include "typed_flags.hpp"
+#include "flag_planes.hpp"
+#include "detail/aligned_words.hpp"
+#include "detail/bits.hpp"
+#include <array>
+#include <vector>
+
+namespace tfl
+{
+
+template<typename Flags>
+class flag_counts;
+
+//!
+//! @brief Number of records having every flag set.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class flag_counts<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //!
+    //! Creates counts of empty array.
+    //!
+    flag_counts() noexcept
+        : m_records(0), m_counts{}
+    {}
+
+    //!
+    //! Creates counts from values in index order.
+    //! @param records number of counted records.
+    //! @param counts number of records per flag.
+    //!
+    flag_counts(size_t records, std::array<uint64_t, sizeof...(Args)> const& counts) noexcept
+        : m_records(records), m_counts(counts)
+    {}
+
+    //!
+    //! Get the number of counted records.
+    //!
+    size_t records() const noexcept
+    {
+        return m_records;
+    }
+
+    //!
+    //! Get the number of records having flag set.
+    //! @param index flag index.
+    //!
+    uint64_t count(size_t index) const noexcept
+    {
+        return m_counts[index];
+    }
+
+    //!
+    //! Get the number of records having the specified flag set.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    uint64_t get() const noexcept
+    {
+        return m_counts[flags_type::template index<T>()];
+    }
+
+    //!
+    //! Get the share of records having the specified flag set.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    double frequency() const noexcept
+    {
+        return m_records ? double(get<T>()) / double(m_records) : 0.0;
+    }
+
+private:
+
+    size_t m_records;
+    std::array<uint64_t, sizeof...(Args)> m_counts;
+};
+
+template<typename Flags>
+class co_occurrence_matrix;
+
+//!
+//! @brief Number of records having every pair of flags set together.
+//!
+//! Matrix is symmetric, its diagonal holds the number of records per flag.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class co_occurrence_matrix<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //!
+    //! Creates matrix of empty array.
+    //!
+    co_occurrence_matrix()
+        : m_records(0), m_counts(sizeof...(Args) * sizeof...(Args))
+    {}
+
+    //!
+    //! Get the number of counted records.
+    //!
+    size_t records() const noexcept
+    {
+        return m_records;
+    }
+
+    //!
+    //! Get the number of records having both flags set.
+    //! @param i index of the first flag.
+    //! @param j index of the second flag.
+    //!
+    uint64_t count(size_t i, size_t j) const noexcept
+    {
+        return m_counts[i * sizeof...(Args) + j];
+    }
+
+    //!
+    //! Get the number of records having both specified flags set.
+    //! @param A type of the first flag.
+    //! @param B type of the second flag.
+    //!
+    template<typename A, typename B>
+    uint64_t get() const noexcept
+    {
+        return count(flags_type::template index<A>(), flags_type::template index<B>());
+    }
+
+    //!
+    //! Returns counts row by row, size() * size() values.
+    //!
+    uint64_t const* data() const noexcept
+    {
+        return m_counts.data();
+    }
+
+    //!
+    //! Get the number of rows and columns.
+    //!
+    static constexpr size_t size() noexcept
+    {
+        return sizeof...(Args);
+    }
+
+    //!
+    //! Adds pair counts of bitmaps of equal length.
+    //! @param planes bitmap of every flag in index order.
+    //! @param words number of words in every bitmap.
+    //! @param records number of records in bitmaps.
+    //!
+    void add_planes(uint64_t const* const* planes, size_t words, size_t records) noexcept
+    {
+        constexpr size_t n = sizeof...(Args);
+        uint64_t both[16];
+        size_t w = 0;
+        for (; w + 16 <= words; w += 16) {
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t const* const a = planes[i] + w;
+                m_counts[i * n + i] += detail::popcount16(a);
+                for (size_t j = i + 1; j < n; ++j) {
+                    uint64_t const* const b = planes[j] + w;
+                    for (size_t k = 0; k < 16; ++k)
+                        both[k] = a[k] & b[k];
+                    m_counts[i * n + j] += detail::popcount16(both);
+                }
+            }
+        }
+        for (; w < words; ++w) {
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = i; j < n; ++j)
+                    m_counts[i * n + j] += detail::popcount64(planes[i][w] & planes[j][w]);
+            }
+        }
+        m_records += records;
+    }
+
+    //!
+    //! Copies upper triangle to the lower one, called after all planes are added.
+    //!
+    void mirror() noexcept
+    {
+        constexpr size_t n = sizeof...(Args);
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = i + 1; j < n; ++j)
+                m_counts[j * n + i] = m_counts[i * n + j];
+    }
+
+private:
+
+    size_t m_records;
+    std::vector<uint64_t> m_counts;
+};
+
+namespace detail
+{
+
+//
+// Transposes records in groups of 1024 into 16 words per flag
+// and passes them to fn(planes, records).
+//
+template<typename Flags, typename Fn>
+void for_each_plane_block(Flags const* data, size_t n, Fn&& fn)
+{
+    constexpr size_t flags = Flags::size();
+    constexpr size_t block_rows = 16 * 64;
+    aligned_words block(flags * 16);
+    uint64_t const* planes[flags + 1];
+    for (size_t k = 0; k < flags; ++k)
+        planes[k] = block.data() + k * 16;
+    uint64_t words[storage_access::bytes<Flags>() * 8 + 1];
+    auto const raw = reinterpret_cast<uint8_t const*>(data);
+    for (size_t first = 0; first < n; first += block_rows) {
+        size_t const rows = n - first < block_rows ? n - first : block_rows;
+        for (size_t s = 0; s < 16; ++s) {
+            size_t const offset = s * 64;
+            size_t const count = offset < rows ? (rows - offset < 64 ? rows - offset : 64) : 0;
+            if (count)
+                transpose_rows<Flags>(raw + (first + offset) * sizeof(Flags), count, words);
+            for (size_t k = 0; k < flags; ++k)
+                block.data()[k * 16 + s] = count ? words[k] : 0;
+        }
+        fn(planes, rows);
+    }
+}
+
+} // namespace detail
+
+//! @name Flag statistics
+//! @{
+
+//!
+//! Counts records having every flag set. Records are transposed into
+//! per-flag bitmaps by 1024 and counted with carry-save popcount.
+//! @param data array of flags.
+//! @param n number of records.
+//!
+template<typename... Args>
+flag_counts<typed_flags<Args...>> flag_frequencies(typed_flags<Args...> const* data, size_t n)
+{
+    std::array<uint64_t, sizeof...(Args)> counts{};
+    detail::for_each_plane_block(data, n, [&](uint64_t const* const* planes, size_t) {
+        for (size_t k = 0; k < sizeof...(Args); ++k)
+            counts[k] += detail::popcount16(planes[k]);
+    });
+    return flag_counts<typed_flags<Args...>>(n, counts);
+}
+
+//!
+//! Counts records having every flag set.
+//! @param planes per-flag bitmaps.
+//!
+template<typename... Args>
+flag_counts<typed_flags<Args...>> flag_frequencies(flag_planes<typed_flags<Args...>> const& planes)
+{
+    std::array<uint64_t, sizeof...(Args)> counts{};
+    for (size_t k = 0; k < sizeof...(Args); ++k) {
+        uint64_t const* const words = planes.plane(k);
+        size_t w = 0;
+        for (; w + 16 <= planes.stride(); w += 16)
+            counts[k] += detail::popcount16(words + w);
+        for (; w < planes.stride(); ++w)
+            counts[k] += detail::popcount64(words[w]);
+    }
+    return flag_counts<typed_flags<Args...>>(planes.size(), counts);
+}
+
+//!
+//! Counts records having every pair of flags set. Every pair of per-flag
+//! bitmaps is AND-ed and counted with carry-save popcount.
+//! @param data array of flags.
+//! @param n number of records.
+//!
+template<typename... Args>
+co_occurrence_matrix<typed_flags<Args...>> co_occurrence(typed_flags<Args...> const* data, size_t n)
+{
+    co_occurrence_matrix<typed_flags<Args...>> res;
+    detail::for_each_plane_block(data, n, [&](uint64_t const* const* planes, size_t rows) {
+        res.add_planes(planes, 16, rows);
+    });
+    res.mirror();
+    return res;
+}
+
+//!
+//! Counts records having every pair of flags set.
+//! @param planes per-flag bitmaps.
+//!
+template<typename... Args>
+co_occurrence_matrix<typed_flags<Args...>> co_occurrence(flag_planes<typed_flags<Args...>> const& planes)
+{
+    co_occurrence_matrix<typed_flags<Args...>> res;
+    uint64_t const* words[sizeof...(Args) + 1];
+    for (size_t k = 0; k < sizeof...(Args); ++k)
+        words[k] = planes.plane(k);
+    res.add_planes(words, planes.stride(), planes.size());
+    res.mirror();
+    return res;
+}
+
+//! @}
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,331 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_BULK_HPP_
+#define _TFL_FLAGS_BULK_HPP_
+
+#include "typed_flags.hpp"
+#include "flags_query.hpp"
+#include "detail/bits.hpp"
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace tfl
+{
+namespace detail
+{
+
+#if defined(__AVX2__)
+
+typedef __m256i bulk_vec;
+
+inline bulk_vec bulk_load(uint8_t const* p) noexcept
+{
+    return _mm256_load_si256(reinterpret_cast<bulk_vec const*>(p));
+}
+
+inline bulk_vec bulk_loadu(uint8_t const* p) noexcept
+{
+    return _mm256_loadu_si256(reinterpret_cast<bulk_vec const*>(p));
+}
+
+inline void bulk_store(uint8_t* p, bulk_vec v) noexcept
+{
+    _mm256_store_si256(reinterpret_cast<bulk_vec*>(p), v);
+}
+
+#elif defined(__SSE2__)
+
+typedef __m128i bulk_vec;
+
+inline bulk_vec bulk_load(uint8_t const* p) noexcept
+{
+    return _mm_load_si128(reinterpret_cast<bulk_vec const*>(p));
+}
+
+inline bulk_vec bulk_loadu(uint8_t const* p) noexcept
+{
+    return _mm_loadu_si128(reinterpret_cast<bulk_vec const*>(p));
+}
+
+inline void bulk_store(uint8_t* p, bulk_vec v) noexcept
+{
+    _mm_store_si128(reinterpret_cast<bulk_vec*>(p), v);
+}
+
+#endif
+
+struct bulk_or
+{
+    template<typename T>
+    static T apply(T a, T b) noexcept {
+        return T(a | b);
+    }
+#if defined(__AVX2__)
+    static bulk_vec apply(bulk_vec a, bulk_vec b) noexcept {
+        return _mm256_or_si256(a, b);
+    }
+#elif defined(__SSE2__)
+    static bulk_vec apply(bulk_vec a, bulk_vec b) noexcept {
+        return _mm_or_si128(a, b);
+    }
+#endif
+};
+
+struct bulk_and
+{
+    template<typename T>
+    static T apply(T a, T b) noexcept {
+        return T(a & b);
+    }
+#if defined(__AVX2__)
+    static bulk_vec apply(bulk_vec a, bulk_vec b) noexcept {
+        return _mm256_and_si256(a, b);
+    }
+#elif defined(__SSE2__)
+    static bulk_vec apply(bulk_vec a, bulk_vec b) noexcept {
+        return _mm_and_si128(a, b);
+    }
+#endif
+};
+
+struct bulk_xor
+{
+    template<typename T>
+    static T apply(T a, T b) noexcept {
+        return T(a ^ b);
+    }
+#if defined(__AVX2__)
+    static bulk_vec apply(bulk_vec a, bulk_vec b) noexcept {
+        return _mm256_xor_si256(a, b);
+    }
+#elif defined(__SSE2__)
+    static bulk_vec apply(bulk_vec a, bulk_vec b) noexcept {
+        return _mm_xor_si128(a, b);
+    }
+#endif
+};
+
+//
+// Applies bitwise operation to byte ranges: dst = dst op src.
+// Destination is aligned by peeling leading bytes, then vector stores are
+// aligned while source loads are unaligned unless source is aligned too.
+// Padding bits stay zeros since they are zeros in both operands.
+//
+template<typename Op>
+void bulk_bitwise(uint8_t* dst, uint8_t const* src, size_t bytes) noexcept
+{
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    constexpr size_t width = sizeof(bulk_vec);
+    size_t const misalign = reinterpret_cast<uintptr_t>(dst) % width;
+    size_t const head = misalign ? width - misalign : 0;
+    if (bytes >= head + width) {
+        for (; i < head; ++i)
+            dst[i] = Op::apply(dst[i], src[i]);
+        if (reinterpret_cast<uintptr_t>(src + i) % width == 0) {
+            for (; i + width <= bytes; i += width)
+                bulk_store(dst + i, Op::apply(bulk_load(dst + i), bulk_load(src + i)));
+        }
+        else {
+            for (; i + width <= bytes; i += width)
+                bulk_store(dst + i, Op::apply(bulk_load(dst + i), bulk_loadu(src + i)));
+        }
+    }
+#endif
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t a, b;
+        memcpy(&a, dst + i, 8);
+        memcpy(&b, src + i, 8);
+        a = Op::apply(a, b);
+        memcpy(dst + i, &a, 8);
+    }
+    for (; i < bytes; ++i)
+        dst[i] = Op::apply(dst[i], src[i]);
+}
+
+template<typename Op, typename Flags>
+void bulk_bitwise(Flags* dst, Flags const* src, size_t n) noexcept
+{
+    if (storage_access::bytes<Flags>() == 0)
+        return;
+    bulk_bitwise<Op>(reinterpret_cast<uint8_t*>(dst), reinterpret_cast<uint8_t const*>(src),
+                     n * sizeof(Flags));
+}
+
+//
+// Selective update of records whose storage fits machine word W.
+// Selection is turned into all-ones or all-zeros mask, so the loop
+// has no branches and can be vectorized.
+//
+template<typename Pred, typename W>
+void update_word_array(uint8_t* data, size_t n, W pm, W sm, W rm) noexcept
+{
+    for (size_t i = 0; i < n; ++i) {
+        W w;
+        memcpy(&w, data + i * sizeof(W), sizeof(W));
+        W const sel = W(0) - W(Pred::test_word(w, pm));
+        w = W((w | (sm & sel)) & ~(rm & sel));
+        memcpy(data + i * sizeof(W), &w, sizeof(W));
+    }
+}
+
+template<typename Pred, typename W, typename Flags>
+void update_words(Flags* data, size_t n, Flags const& pm, Flags const& sm, Flags const& rm) noexcept
+{
+    auto const word = [](Flags const& f) {
+        W w;
+        memcpy(&w, storage_access::data(f), sizeof(W));
+        return w;
+    };
+    update_word_array<Pred, W>(reinterpret_cast<uint8_t*>(data), n, word(pm), word(sm), word(rm));
+}
+
+template<size_t Bytes>
+using bytes_tag = std::integral_constant<size_t, Bytes>;
+
+template<typename Pred, typename Flags>
+void update_records(Flags* data, size_t n, Flags const& pm, Flags const& sm, Flags const& rm, bytes_tag<1>) noexcept
+{
+    update_words<Pred, uint8_t>(data, n, pm, sm, rm);
+}
+
+template<typename Pred, typename Flags>
+void update_records(Flags* data, size_t n, Flags const& pm, Flags const& sm, Flags const& rm, bytes_tag<2>) noexcept
+{
+    update_words<Pred, uint16_t>(data, n, pm, sm, rm);
+}
+
+template<typename Pred, typename Flags>
+void update_records(Flags* data, size_t n, Flags const& pm, Flags const& sm, Flags const& rm, bytes_tag<4>) noexcept
+{
+    update_words<Pred, uint32_t>(data, n, pm, sm, rm);
+}
+
+template<typename Pred, typename Flags>
+void update_records(Flags* data, size_t n, Flags const& pm, Flags const& sm, Flags const& rm, bytes_tag<8>) noexcept
+{
+    update_words<Pred, uint64_t>(data, n, pm, sm, rm);
+}
+
+//
+// Records of other sizes are split into 64-bit chunks of compile-time
+// length, so loads and stores are still word-sized.
+//
+template<typename Pred, typename Flags, size_t Bytes>
+void update_records(Flags* data, size_t n, Flags const& pm, Flags const& sm, Flags const& rm, bytes_tag<Bytes>) noexcept
+{
+    constexpr size_t chunks = (Bytes + 7) / 8;
+    constexpr size_t tail = Bytes - (chunks - 1) * 8;
+    uint64_t p[chunks], s[chunks], r[chunks];
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t const len = c + 1 < chunks ? 8 : tail;
+        p[c] = load_le(storage_access::data(pm) + c * 8, len);
+        s[c] = load_le(storage_access::data(sm) + c * 8, len);
+        r[c] = load_le(storage_access::data(rm) + c * 8, len);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t* const record = storage_access::data(data[i]);
+        uint64_t w[chunks];
+        bool match = Pred::conjunctive;
+        for (size_t c = 0; c < chunks; ++c) {
+            w[c] = load_le(record + c * 8, c + 1 < chunks ? 8 : tail);
+            bool const t = Pred::test_word(w[c], p[c]);
+            match = Pred::conjunctive ? (match & t) : (match | t);
+        }
+        uint64_t const sel = uint64_t(0) - uint64_t(match);
+        for (size_t c = 0; c < chunks; ++c)
+            store_le(record + c * 8, (w[c] | (s[c] & sel)) & ~(r[c] & sel), c + 1 < chunks ? 8 : tail);
+    }
+}
+
+} // namespace detail
+
+//! @name Bulk operations
+//! @{
+
+//!
+//! Merges arrays of flags element-wise: dst[i] |= src[i].
+//! @param dst array to modify.
+//! @param src array to merge from.
+//! @param n number of records in both arrays.
+//!
+template<typename... Args>
+void bitwise_or(typed_flags<Args...>* dst, typed_flags<Args...> const* src, size_t n) noexcept
+{
+    detail::bulk_bitwise<detail::bulk_or>(dst, src, n);
+}
+
+//!
+//! Intersects arrays of flags element-wise: dst[i] &= src[i].
+//! @param dst array to modify.
+//! @param src array to intersect with.
+//! @param n number of records in both arrays.
+//!
+template<typename... Args>
+void bitwise_and(typed_flags<Args...>* dst, typed_flags<Args...> const* src, size_t n) noexcept
+{
+    detail::bulk_bitwise<detail::bulk_and>(dst, src, n);
+}
+
+//!
+//! Toggles flags of array element-wise: dst[i] ^= src[i].
+//! @param dst array to modify.
+//! @param src array of toggled flags.
+//! @param n number of records in both arrays.
+//!
+template<typename... Args>
+void bitwise_xor(typed_flags<Args...>* dst, typed_flags<Args...> const* src, size_t n) noexcept
+{
+    detail::bulk_bitwise<detail::bulk_xor>(dst, src, n);
+}
+
+//!
+//! Sets and unsets flags of every record matching predicate.<br>
+//! Unsetting wins if a flag is listed in both modifications.
+//! Records are processed without per-element branches.
+//! @param Pred predicate: all_of, any_of or none_of.
+//! @param data array to modify.
+//! @param n number of records.
+//! @param set_flags<S...> flags to set.
+//! @param reset_flags<R...> flags to unset.
+//!
+template<typename Pred, typename... Args, typename... S, typename... R>
+void update_where(typed_flags<Args...>* data, size_t n, set_flags<S...>, reset_flags<R...> = {}) noexcept
+{
+    typedef typed_flags<Args...> flags_type;
+    constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    auto const pm = detail::list_mask<flags_type, Pred>::get();
+    auto const sm = detail::flags_mask<flags_type, S...>();
+    auto const rm = detail::flags_mask<flags_type, R...>();
+
+    detail::update_records<Pred>(data, n, pm, sm, rm, detail::bytes_tag<bytes>{});
+}
+
+//!
+//! Unsets flags of every record matching predicate.
+//! @param Pred predicate: all_of, any_of or none_of.
+//! @param data array to modify.
+//! @param n number of records.
+//! @param reset_flags<R...> flags to unset.
+//!
+template<typename Pred, typename... Args, typename... R>
+void update_where(typed_flags<Args...>* data, size_t n, reset_flags<R...> reset) noexcept
+{
+    update_where<Pred>(data, n, set_flags<>{}, reset);
+}
+
+//! @}
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,290 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_DELTA_HPP_
+#define _TFL_FLAGS_DELTA_HPP_
+
+#include "typed_flags.hpp"
+#include "detail/bits.hpp"
+#include "detail/visit.hpp"
+#include <stdexcept>
+#include <vector>
+
+namespace tfl
+{
+
+template<typename Flags>
+class flags_delta;
+
+//!
+//! @brief Difference between two values of typed flags.
+//!
+//! Stores XOR mask of changed flags, applying the delta toggles them.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class flags_delta<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Creates empty delta.
+    //!
+    flags_delta() noexcept
+    {}
+
+    //!
+    //! Creates delta from mask of changed flags.
+    //! @param mask changed flags.
+    //!
+    explicit flags_delta(flags_type const& mask) noexcept
+        : m_mask(mask)
+    {}
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Returns mask of changed flags.
+    //!
+    flags_type const& mask() const noexcept
+    {
+        return m_mask;
+    }
+
+    //!
+    //! Checks that nothing is changed.
+    //!
+    bool empty() const noexcept
+    {
+        return m_mask.none();
+    }
+
+    //!
+    //! Checks that the specified flag is changed.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    bool changed() const noexcept
+    {
+        return m_mask.template test<T>();
+    }
+
+    //!
+    //! Get the number of changed flags.
+    //!
+    size_t count() const noexcept
+    {
+        auto const data = detail::storage_access::data(m_mask);
+        size_t const bytes = detail::storage_access::bytes<flags_type>();
+        size_t res = 0;
+        for (size_t offset = 0; offset < bytes; offset += 8) {
+            size_t const n = bytes - offset < 8 ? bytes - offset : 8;
+            res += detail::popcount64(detail::load_le(data + offset, n));
+        }
+        return res;
+    }
+
+    //!
+    //! Calls visitor with type_tag<T> for each changed flag type T
+    //! in index order. Unchanged words of the mask are skipped.
+    //! @param fn visitor.
+    //!
+    template<typename Fn>
+    void for_each_changed(Fn&& fn) const
+    {
+        detail::visit_set_bits<Args...>(detail::storage_access::data(m_mask),
+                                        detail::storage_access::bytes<flags_type>(), fn);
+    }
+
+    //! @}
+
+    bool operator == (flags_delta const& other) const noexcept
+    {
+        return m_mask == other.m_mask;
+    }
+
+    bool operator != (flags_delta const& other) const noexcept
+    {
+        return m_mask != other.m_mask;
+    }
+
+private:
+
+    flags_type m_mask;
+};
+
+//! @name Delta functions
+//! @{
+
+//!
+//! Computes delta turning one value into another.
+//! @param from source value.
+//! @param to target value.
+//! @returns delta such that applying it to from gives to.
+//!
+template<typename... Args>
+flags_delta<typed_flags<Args...>> diff(typed_flags<Args...> const& from, typed_flags<Args...> const& to) noexcept
+{
+    return flags_delta<typed_flags<Args...>>(from ^ to);
+}
+
+//!
+//! Toggles flags changed by delta.
+//! @param flags value to modify.
+//! @param delta changes to apply.
+//!
+template<typename... Args>
+void apply(typed_flags<Args...>& flags, flags_delta<typed_flags<Args...>> const& delta) noexcept
+{
+    flags ^= delta.mask();
+}
+
+//! @}
+
+namespace detail
+{
+
+//
+// Record changes cheaper to store as a list of bit positions are
+// tagged with even header (count << 1), the rest are stored as raw XOR bytes
+// behind header 1.
+//
+template<typename Flags>
+void encode_record_delta(uint8_t const* from, uint8_t const* to, std::vector<uint8_t>& out)
+{
+    constexpr size_t bytes = storage_access::bytes<Flags>();
+    size_t changed = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        changed += popcount64(uint8_t(from[i] ^ to[i]));
+    if (changed >= bytes) {
+        out.push_back(1);
+        for (size_t i = 0; i < bytes; ++i)
+            out.push_back(uint8_t(from[i] ^ to[i]));
+        return;
+    }
+    put_varint(out, changed << 1);
+    size_t prev = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        for (unsigned x = uint8_t(from[i] ^ to[i]); x != 0; x &= x - 1) {
+            size_t const pos = i * 8 + ctz64(x);
+            put_varint(out, pos - prev);
+            prev = pos + 1;
+        }
+    }
+}
+
+} // namespace detail
+
+//! @name Delta streaming
+//! @{
+
+//!
+//! Appends a frame describing changes between two arrays of flags.<br>
+//! Unchanged records are skipped as runs, changed ones are stored as
+//! varint lists of toggled positions, so frame size depends on the number
+//! of changed bits rather than on array length.
+//! @param from previous values.
+//! @param to current values.
+//! @param n number of records in both arrays.
+//! @param out buffer to append frame to.
+//!
+template<typename... Args>
+void encode_deltas(typed_flags<Args...> const* from, typed_flags<Args...> const* to,
+                   size_t n, std::vector<uint8_t>& out)
+{
+    typedef typed_flags<Args...> flags_type;
+    constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    constexpr size_t stride = sizeof(flags_type);
+    auto const src = reinterpret_cast<uint8_t const*>(from);
+    auto const dst = reinterpret_cast<uint8_t const*>(to);
+    size_t const total = n * stride;
+
+    detail::put_varint(out, n);
+    size_t next = 0;
+    for (size_t r = 0; r < n; ++r) {
+        // skip equal words first, records are laid out back to back
+        size_t offset = r * stride;
+        while (offset + 8 <= total && detail::load_le(src + offset) == detail::load_le(dst + offset))
+            offset += 8;
+        if (offset / stride > r)
+            r = offset / stride;
+        if (r >= n)
+            break;
+        if (memcmp(src + r * stride, dst + r * stride, bytes) == 0)
+            continue;
+        detail::put_varint(out, r - next + 1);
+        detail::encode_record_delta<flags_type>(src + r * stride, dst + r * stride, out);
+        next = r + 1;
+    }
+    out.push_back(0);
+}
+
+//!
+//! Applies one frame produced by encode_deltas.<br> Only changed records are touched.
+//! @param data frame start.
+//! @param size number of bytes available.
+//! @param flags array to modify.
+//! @param n number of records in array.
+//! @returns number of bytes consumed, next frame starts right after.
+//! @throws std::invalid_argument if frame is malformed or doesn't match array.
+//!
+template<typename... Args>
+size_t apply_deltas(uint8_t const* data, size_t size, typed_flags<Args...>* flags, size_t n)
+{
+    typedef typed_flags<Args...> flags_type;
+    constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    uint8_t const* it = data;
+    uint8_t const* const end = data + size;
+
+    if (detail::get_varint(it, end) != n)
+        throw std::invalid_argument("Delta frame length mismatch");
+    size_t next = 0;
+    for (uint64_t skip; (skip = detail::get_varint(it, end)) != 0;) {
+        if (skip > n - next)
+            throw std::invalid_argument("Delta record out of range");
+        size_t const r = next + size_t(skip) - 1;
+        uint8_t* const record = detail::storage_access::data(flags[r]);
+        uint64_t const header = detail::get_varint(it, end);
+        if (header == 1) {
+            if (size_t(end - it) < bytes)
+                throw std::invalid_argument("Delta record truncated");
+            for (size_t i = 0; i < bytes; ++i)
+                record[i] ^= *it++;
+            // unused bits of the last byte must stay zeros
+            if (flags_type::size() % 8 != 0)
+                record[bytes - 1] &= uint8_t((1u << (flags_type::size() % 8)) - 1);
+        }
+        else if (header % 2 == 0) {
+            size_t pos = 0;
+            for (uint64_t k = header >> 1; k > 0; --k) {
+                // checked before adding, so huge gaps can't wrap around
+                uint64_t const gap = detail::get_varint(it, end);
+                if (gap >= flags_type::size() - pos)
+                    throw std::invalid_argument("Delta position out of range");
+                pos += size_t(gap);
+                record[pos / 8] ^= uint8_t(1u << (pos % 8));
+                ++pos;
+            }
+        }
+        else
+            throw std::invalid_argument("Malformed delta record");
+        next = r + 1;
+    }
+    return size_t(it - data);
+}
+
+//! @}
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,585 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_FILE_HPP_
+#define _TFL_FLAGS_FILE_HPP_
+
+#include "typed_flags.hpp"
+#include "flag_planes.hpp"
+#include "flags_query.hpp"
+#include "detail/aligned_words.hpp"
+#include "detail/bits.hpp"
+#include "detail/posix_error.hpp"
+#include "detail/layout_hash.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Flags files are mapped as little-endian words"
+#endif
+
+namespace tfl
+{
+
+//!
+//! @brief Header at the start of flags file.
+//!
+//! File consists of the header followed by blocks of block_rows records.
+//! Every block starts with 32-bit numbers of set bits per flag, padded
+//! to 64 bytes, followed by one bitmap of block_rows bits per flag.
+//! Bit r of bitmap word w is the flag of record w * 64 + r of the block.
+//! The last block may be incomplete, unused bits are zeros. Blocks have
+//! fixed size, so file is appended without moving existing data.
+//!
+struct flags_file_header
+{
+    char magic[8];          //!< "TFLFILE" followed by zero
+    uint32_t version;       //!< format version, currently 3
+    uint32_t flag_count;    //!< number of flag types
+    uint64_t layout_hash;   //!< hash of flag names in order, see flag_name
+    uint64_t block_rows;    //!< number of records per block, a multiple of 512
+    uint64_t rows;          //!< number of records, written last on every flush
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(flags_file_header) == 64, "Flags file header must occupy 64 bytes");
+
+namespace detail
+{
+
+constexpr char flags_file_magic[8] = {'T', 'F', 'L', 'F', 'I', 'L', 'E', 0};
+constexpr uint32_t flags_file_version = 3;
+
+inline size_t summary_bytes(size_t flags) noexcept
+{
+    return (flags * sizeof(uint32_t) + 63) / 64 * 64;
+}
+
+inline size_t block_bytes(size_t flags, size_t block_rows) noexcept
+{
+    return summary_bytes(flags) + flags * block_rows / 8;
+}
+
+//
+// Checks that header describes flags with specified layout.
+//
+inline void check_header(flags_file_header const& h, size_t flags, uint64_t hash)
+{
+    if (memcmp(h.magic, flags_file_magic, sizeof(h.magic)) != 0)
+        throw std::invalid_argument("Not a flags file");
+    if (h.version != flags_file_version)
+        throw std::invalid_argument("Unsupported flags file version");
+    if (h.flag_count != flags || h.layout_hash != hash)
+        throw std::invalid_argument("Flags file layout doesn't match flags type");
+    if (h.block_rows == 0 || h.block_rows % 512 != 0 || h.block_rows > (uint64_t(1) << 31))
+        throw std::invalid_argument("Invalid flags file block size");
+}
+
+} // namespace detail
+
+template<typename Flags>
+class flags_file_writer;
+
+//!
+//! @brief Appends records to flags file.
+//!
+//! Records are transposed into per-flag bitmaps of the current block held
+//! in memory, complete blocks are written once. Record count in the header
+//! is updated by flush, so readers never see partially written records.
+//! @param Args... user defined types with flag_name specialized.
+//!
+template<typename... Args>
+class flags_file_writer<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    static_assert(sizeof...(Args) > 0, "Flags file requires at least one flag");
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Opens file for appending, creates it if it doesn't exist.
+    //! @param path file path.
+    //! @param block_rows number of records per block of a new file, a multiple of 512.
+    //! Existing files keep their block size.
+    //! @throws std::system_error if file can't be opened or read.
+    //! @throws std::invalid_argument if file layout doesn't match flags type.
+    //!
+    explicit flags_file_writer(char const* path, size_t block_rows = 65536)
+        : m_fd(::open(path, O_RDWR | O_CREAT, 0644))
+    {
+        if (m_fd < 0)
+            detail::throw_errno("Can't open flags file");
+        try {
+            open(block_rows, detail::layout_hash<Args...>());
+        }
+        catch (...) {
+            ::close(m_fd);
+            throw;
+        }
+    }
+
+    flags_file_writer(flags_file_writer const&) = delete;
+    flags_file_writer& operator = (flags_file_writer const&) = delete;
+
+    //!
+    //! Flushes pending records and closes file. Errors are ignored, call flush to detect them.
+    //!
+    ~flags_file_writer()
+    {
+        try {
+            flush();
+        }
+        catch (...) {
+        }
+        ::close(m_fd);
+    }
+
+    //! @}
+    //! @name Modifiers
+    //! @{
+
+    //!
+    //! Appends records.<br> Complete blocks are written immediately,
+    //! records become visible to readers after flush.
+    //! @param data array of records.
+    //! @param n number of records.
+    //! @throws std::system_error if file can't be written.
+    //!
+    void append(flags_type const* data, size_t n)
+    {
+        auto raw = reinterpret_cast<uint8_t const*>(data);
+        uint64_t words[detail::storage_access::bytes<flags_type>() * 8 + 1];
+        while (n > 0) {
+            size_t const fill = m_header.rows % m_header.block_rows;
+            size_t const room = m_header.block_rows - fill;
+            size_t rows = n < room ? n : room;
+            if (rows > 64)
+                rows = 64;
+            detail::transpose_rows<flags_type>(raw, rows, words);
+            unsigned const shift = fill % 64;
+            for (size_t k = 0; k < sizeof...(Args); ++k) {
+                uint64_t* const plane = bitmap(k) + fill / 64;
+                plane[0] |= words[k] << shift;
+                if (shift != 0 && shift + rows > 64)
+                    plane[1] |= words[k] >> (64 - shift);
+                summary()[k] += uint32_t(detail::popcount64(words[k]));
+            }
+            m_header.rows += rows;
+            m_dirty = true;
+            raw += rows * sizeof(flags_type);
+            n -= rows;
+            if (rows == room)
+                write_block();
+        }
+    }
+
+    void append(flags_type const& flags)
+    {
+        append(&flags, 1);
+    }
+
+    //!
+    //! Writes incomplete block and record count.
+    //! @throws std::system_error if file can't be written.
+    //!
+    void flush()
+    {
+        if (!m_dirty)
+            return;
+        if (m_header.rows % m_header.block_rows != 0)
+            write(m_block.data(), m_block_bytes, block_offset(m_header.rows / m_header.block_rows));
+        write(&m_header, sizeof(m_header), 0);
+        m_dirty = false;
+    }
+
+    //! @}
+    //! @name Capacity
+    //! @{
+
+    //!
+    //! Get the number of records including pending ones.
+    //!
+    size_t size() const noexcept
+    {
+        return size_t(m_header.rows);
+    }
+
+    //!
+    //! Get the number of records per block.
+    //!
+    size_t block_rows() const noexcept
+    {
+        return size_t(m_header.block_rows);
+    }
+
+    //! @}
+
+private:
+
+    void open(size_t block_rows, uint64_t layout)
+    {
+        struct stat st;
+        if (::fstat(m_fd, &st) != 0)
+            detail::throw_errno("Can't stat flags file");
+        if (st.st_size == 0) {
+            m_header = flags_file_header{};
+            memcpy(m_header.magic, detail::flags_file_magic, sizeof(m_header.magic));
+            m_header.version = detail::flags_file_version;
+            m_header.flag_count = sizeof...(Args);
+            m_header.layout_hash = layout;
+            m_header.block_rows = block_rows;
+            detail::check_header(m_header, sizeof...(Args), layout);
+            m_dirty = true;
+        }
+        else {
+            read(&m_header, sizeof(m_header), 0);
+            detail::check_header(m_header, sizeof...(Args), layout);
+            m_dirty = false;
+        }
+        m_block_bytes = detail::block_bytes(sizeof...(Args), size_t(m_header.block_rows));
+        detail::aligned_words(m_block_bytes / sizeof(uint64_t)).swap(m_block);
+        // continue incomplete block
+        if (m_header.rows % m_header.block_rows != 0)
+            read(m_block.data(), m_block_bytes, block_offset(m_header.rows / m_header.block_rows));
+    }
+
+    uint32_t* summary() noexcept
+    {
+        return reinterpret_cast<uint32_t*>(m_block.data());
+    }
+
+    uint64_t* bitmap(size_t index) noexcept
+    {
+        return m_block.data() + (detail::summary_bytes(sizeof...(Args)) + index * m_header.block_rows / 8) / 8;
+    }
+
+    off_t block_offset(uint64_t block) const noexcept
+    {
+        return off_t(sizeof(flags_file_header) + block * m_block_bytes);
+    }
+
+    void write_block()
+    {
+        write(m_block.data(), m_block_bytes, block_offset(m_header.rows / m_header.block_rows - 1));
+        memset(m_block.data(), 0, m_block_bytes);
+    }
+
+    void write(void const* data, size_t size, off_t offset)
+    {
+        auto src = static_cast<char const*>(data);
+        while (size > 0) {
+            ssize_t const res = ::pwrite(m_fd, src, size, offset);
+            if (res < 0 && errno == EINTR)
+                continue;
+            if (res <= 0)
+                detail::throw_errno("Can't write flags file");
+            src += res;
+            size -= size_t(res);
+            offset += res;
+        }
+    }
+
+    void read(void* data, size_t size, off_t offset)
+    {
+        auto dst = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t const res = ::pread(m_fd, dst, size, offset);
+            if (res < 0 && errno == EINTR)
+                continue;
+            if (res < 0)
+                detail::throw_errno("Can't read flags file");
+            if (res == 0)
+                throw std::invalid_argument("Flags file is truncated");
+            dst += res;
+            size -= size_t(res);
+            offset += res;
+        }
+    }
+
+    int m_fd;
+    bool m_dirty;
+    flags_file_header m_header;
+    size_t m_block_bytes;
+    detail::aligned_words m_block;
+};
+
+template<typename Flags>
+class flags_file_reader;
+
+//!
+//! @brief Memory mapped read-only view of flags file.
+//!
+//! Opening maps the file without reading records, bitmaps are accessed
+//! in place. Counting queries skip blocks whose per-flag summaries
+//! already decide the result.
+//! @param Args... user defined types with flag_name specialized.
+//!
+template<typename... Args>
+class flags_file_reader<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    static_assert(sizeof...(Args) > 0, "Flags file requires at least one flag");
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Maps file into memory.
+    //! @param path file path.
+    //! @throws std::system_error if file can't be opened or mapped.
+    //! @throws std::invalid_argument if file is truncated or its layout doesn't match flags type.
+    //!
+    explicit flags_file_reader(char const* path)
+    {
+        int const fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            detail::throw_errno("Can't open flags file");
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            detail::throw_errno("Can't stat flags file");
+        }
+        m_size = size_t(st.st_size);
+        if (m_size < sizeof(flags_file_header)) {
+            ::close(fd);
+            throw std::invalid_argument("Flags file is truncated");
+        }
+        m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (m_data == MAP_FAILED)
+            detail::throw_errno("Can't map flags file");
+        try {
+            detail::check_header(header(), sizeof...(Args), detail::layout_hash<Args...>());
+            // Writer may append to mapped file, the reader sees records present at opening
+            m_rows = size_t(header().rows);
+            m_block_rows = size_t(header().block_rows);
+            m_block_bytes = detail::block_bytes(sizeof...(Args), m_block_rows);
+            if ((m_size - sizeof(flags_file_header)) / m_block_bytes < block_count())
+                throw std::invalid_argument("Flags file is truncated");
+        }
+        catch (...) {
+            ::munmap(m_data, m_size);
+            throw;
+        }
+    }
+
+    flags_file_reader(flags_file_reader const&) = delete;
+    flags_file_reader& operator = (flags_file_reader const&) = delete;
+
+    ~flags_file_reader()
+    {
+        ::munmap(m_data, m_size);
+    }
+
+    //!
+    //! Hints the kernel that the file will be scanned sequentially.
+    //!
+    void advise_sequential() const noexcept
+    {
+        ::madvise(m_data, m_size, MADV_SEQUENTIAL);
+    }
+
+    //! @}
+    //! @name Capacity
+    //! @{
+
+    //!
+    //! Get the number of records.
+    //!
+    size_t size() const noexcept
+    {
+        return m_rows;
+    }
+
+    //!
+    //! Get the number of records per block.
+    //!
+    size_t block_rows() const noexcept
+    {
+        return m_block_rows;
+    }
+
+    //!
+    //! Get the number of blocks including incomplete one.
+    //!
+    size_t block_count() const noexcept
+    {
+        return (m_rows + m_block_rows - 1) / m_block_rows;
+    }
+
+    //!
+    //! Get the number of records in block.
+    //! @param block block index.
+    //!
+    size_t block_size(size_t block) const noexcept
+    {
+        size_t const first = block * block_rows();
+        return size() - first < block_rows() ? size() - first : block_rows();
+    }
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Returns bitmap of flag in block, bits of missing records are zeros.
+    //! @param index flag index.
+    //! @param block block index.
+    //!
+    uint64_t const* plane(size_t index, size_t block) const noexcept
+    {
+        return reinterpret_cast<uint64_t const*>(block_data(block) + detail::summary_bytes(sizeof...(Args))
+                                                 + index * block_rows() / 8);
+    }
+
+    template<typename T>
+    uint64_t const* plane(size_t block) const noexcept
+    {
+        return plane(flags_type::template index<T>(), block);
+    }
+
+    //!
+    //! Get the number of records in block having the specified flag set.
+    //! @param T flag type.
+    //! @param block block index.
+    //!
+    template<typename T>
+    size_t summary(size_t block) const noexcept
+    {
+        return summary(flags_type::template index<T>(), block);
+    }
+
+    size_t summary(size_t index, size_t block) const noexcept
+    {
+        return reinterpret_cast<uint32_t const*>(block_data(block))[index];
+    }
+
+    //!
+    //! Returns the value of the specified flag of record.
+    //! @param T flag type.
+    //! @param row record index.
+    //!
+    template<typename T>
+    bool test(size_t row) const noexcept
+    {
+        size_t const offset = row % block_rows();
+        return (plane<T>(row / block_rows())[offset / 64] >> (offset % 64)) & 1;
+    }
+
+    //!
+    //! Returns record.
+    //! @param row record index.
+    //!
+    flags_type get(size_t row) const noexcept
+    {
+        flags_type res;
+        size_t const block = row / block_rows();
+        size_t const offset = row % block_rows();
+        uint8_t* const dst = detail::storage_access::data(res);
+        for (size_t k = 0; k < sizeof...(Args); ++k)
+            dst[k / 8] |= uint8_t(((plane(k, block)[offset / 64] >> (offset % 64)) & 1) << (k % 8));
+        return res;
+    }
+
+    //! @}
+    //! @name Queries
+    //! @{
+
+    //!
+    //! Get the number of records matching predicate.
+    //! @param Pred predicate: all_of, any_of or none_of.
+    //!
+    template<typename Pred>
+    size_t count() const noexcept
+    {
+        return count<Pred>(0, block_count());
+    }
+
+    //!
+    //! Get the number of records matching predicate within range of blocks,
+    //! so that disjoint ranges can be scanned by different threads.
+    //! @param Pred predicate: all_of, any_of or none_of.
+    //! @param first index of the first block.
+    //! @param last index past the last block.
+    //!
+    template<typename Pred>
+    size_t count(size_t first, size_t last) const noexcept
+    {
+        typedef detail::list_indices<flags_type, Pred> list;
+        auto const index = list::get();
+        size_t res = 0;
+        for (size_t b = first; b < last; ++b) {
+            size_t const rows = block_size(b);
+            // Summaries tell how many rows pass each listed flag. Summary of
+            // incomplete block may already count rows appended after opening
+            if (rows == m_block_rows) {
+                size_t empty = 0, full = 0;
+                for (size_t k = 0; k < list::size; ++k) {
+                    size_t const set = summary(index[k], b);
+                    size_t const pass = Pred::inverted ? rows - set : set;
+                    empty += pass == 0;
+                    full += pass == rows;
+                }
+                if (Pred::conjunctive ? empty != 0 : full != 0) {
+                    res += Pred::conjunctive ? 0 : rows;
+                    continue;
+                }
+                if (Pred::conjunctive ? full == list::size : empty == list::size) {
+                    res += Pred::conjunctive ? rows : 0;
+                    continue;
+                }
+            }
+            uint64_t const* planes[list::size + 1];
+            for (size_t k = 0; k < list::size; ++k)
+                planes[k] = plane(index[k], b);
+            size_t const words = rows / 64;
+            for (size_t w = 0; w < words; ++w)
+                res += detail::popcount64(detail::combine_planes<Pred>(planes, list::size, w));
+            if (rows % 64 != 0) {
+                uint64_t const tail = detail::combine_planes<Pred>(planes, list::size, words);
+                res += detail::popcount64(tail & ((uint64_t(1) << (rows % 64)) - 1));
+            }
+        }
+        return res;
+    }
+
+    //! @}
+
+private:
+
+    flags_file_header const& header() const noexcept
+    {
+        return *static_cast<flags_file_header const*>(m_data);
+    }
+
+    uint8_t const* block_data(size_t block) const noexcept
+    {
+        return static_cast<uint8_t const*>(m_data) + sizeof(flags_file_header) + block * m_block_bytes;
+    }
+
+    void* m_data;
+    size_t m_size;
+    size_t m_rows;
+    size_t m_block_rows;
+    size_t m_block_bytes;
+};
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,372 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_PARALLEL_HPP_
+#define _TFL_FLAGS_PARALLEL_HPP_
+
+#include "typed_flags.hpp"
+#include "flags_query.hpp"
+#include "detail/partials.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tfl
+{
+
+//!
+//! @brief Fixed set of threads running batch operations.
+//!
+//! Calling thread takes part in every run, so pool of size 1 has no
+//! workers and runs everything inline. Tasks are handed out one by one
+//! from shared counter, threads finishing early take more of them.
+//! Runs are serialized.
+//!
+class thread_pool
+{
+public:
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Starts size - 1 worker threads.
+    //! @param size number of threads running tasks including the calling one.
+    //!
+    explicit thread_pool(size_t size = std::thread::hardware_concurrency())
+        : m_size(size ? size : 1), m_job(nullptr), m_generation(0), m_busy(0), m_stop(false)
+    {
+        for (size_t i = 1; i < m_size; ++i)
+            m_workers.emplace_back([this, i] { work(i); });
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator = (thread_pool const&) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& w : m_workers)
+            w.join();
+    }
+
+    //!
+    //! Returns pool shared by batch operations, sized to hardware concurrency.
+    //!
+    static thread_pool& instance()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+    //! @}
+
+    //!
+    //! Get the number of threads running tasks.
+    //!
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    //!
+    //! Runs fn(task, thread) for every task in [0, tasks) and waits for completion.
+    //! Thread index is less than size(), a thread runs one task at a time.
+    //! @param tasks number of tasks.
+    //! @param fn task function.
+    //! @throws the first exception thrown by task, remaining tasks are skipped.
+    //!
+    template<typename Fn>
+    void run(size_t tasks, Fn&& fn)
+    {
+        std::lock_guard<std::mutex> serial(m_run_mutex);
+        job j{&invoke<typename std::remove_reference<Fn>::type>, &fn, tasks, {0}, nullptr, {}};
+        if (m_size > 1 && tasks > 1) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_job = &j;
+                m_busy = m_size - 1;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+            execute(j, 0);
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this] { return m_busy == 0; });
+            m_job = nullptr;
+        }
+        else
+            execute(j, 0);
+        if (j.error)
+            std::rethrow_exception(j.error);
+    }
+
+private:
+
+    struct job
+    {
+        void (*call)(void*, size_t, size_t);
+        void* fn;
+        size_t tasks;
+        std::atomic<size_t> next;
+        std::exception_ptr error;
+        std::mutex error_mutex;
+    };
+
+    template<typename Fn>
+    static void invoke(void* fn, size_t task, size_t thread)
+    {
+        (*static_cast<Fn*>(fn))(task, thread);
+    }
+
+    static void execute(job& j, size_t thread) noexcept
+    {
+        for (size_t task; (task = j.next.fetch_add(1, std::memory_order_relaxed)) < j.tasks;) {
+            try {
+                j.call(j.fn, task, thread);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(j.error_mutex);
+                if (!j.error)
+                    j.error = std::current_exception();
+                j.next.store(j.tasks, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void work(size_t thread)
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+            job& j = *m_job;
+            lock.unlock();
+            execute(j, thread);
+            lock.lock();
+            if (--m_busy == 0)
+                m_done.notify_one();
+        }
+    }
+
+    size_t const m_size;
+    std::vector<std::thread> m_workers;
+    std::mutex m_run_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    job* m_job;
+    uint64_t m_generation;
+    size_t m_busy;
+    bool m_stop;
+};
+
+namespace detail
+{
+
+//
+// Records per task, a multiple of 64 so that every task starts
+// at cache line boundary relative to the array start.
+//
+constexpr size_t parallel_chunk = 1 << 14;
+
+inline size_t chunk_count(size_t n) noexcept
+{
+    return (n + parallel_chunk - 1) / parallel_chunk;
+}
+
+} // namespace detail
+
+//! @name Parallel batch operations
+//! @{
+
+//!
+//! Counts records matching predicate.
+//! @param Pred predicate: all_of, any_of or none_of.
+//! @param data array of flags.
+//! @param n number of records.
+//! @param pool threads to run on.
+//!
+template<typename Pred, typename... Args>
+size_t parallel_count(typed_flags<Args...> const* data, size_t n, thread_pool& pool = thread_pool::instance())
+{
+    typedef typed_flags<Args...> flags_type;
+    constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    auto const mask = detail::list_mask<flags_type, Pred>::get();
+    auto const m = detail::storage_access::data(mask);
+
+    detail::partials<size_t> counts(pool.size(), 0);
+    pool.run(detail::chunk_count(n), [&](size_t task, size_t thread) {
+        size_t const first = task * detail::parallel_chunk;
+        size_t const last = n - first < detail::parallel_chunk ? n : first + detail::parallel_chunk;
+        size_t res = 0;
+        for (size_t i = first; i < last; ++i)
+            res += detail::test_raw<Pred, bytes>(detail::storage_access::data(data[i]), m);
+        counts[thread] += res;
+    });
+    size_t res = 0;
+    for (size_t t = 0; t < pool.size(); ++t)
+        res += counts[t];
+    return res;
+}
+
+//!
+//! Collects indexes of records matching predicate.
+//! @param Pred predicate: all_of, any_of or none_of.
+//! @param data array of flags.
+//! @param n number of records.
+//! @param pool threads to run on.
+//! @returns indexes in ascending order.
+//!
+template<typename Pred, typename... Args>
+std::vector<size_t> parallel_filter(typed_flags<Args...> const* data, size_t n, thread_pool& pool = thread_pool::instance())
+{
+    typedef typed_flags<Args...> flags_type;
+    constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    auto const mask = detail::list_mask<flags_type, Pred>::get();
+    auto const m = detail::storage_access::data(mask);
+
+    // the first pass counts matches per chunk, so the second one
+    // writes indexes straight to their final positions
+    size_t const chunks = detail::chunk_count(n);
+    std::vector<size_t> offsets(chunks + 1);
+    pool.run(chunks, [&](size_t task, size_t) {
+        size_t const first = task * detail::parallel_chunk;
+        size_t const last = n - first < detail::parallel_chunk ? n : first + detail::parallel_chunk;
+        size_t res = 0;
+        for (size_t i = first; i < last; ++i)
+            res += detail::test_raw<Pred, bytes>(detail::storage_access::data(data[i]), m);
+        offsets[task + 1] = res;
+    });
+    for (size_t c = 0; c < chunks; ++c)
+        offsets[c + 1] += offsets[c];
+
+    std::vector<size_t> res(offsets[chunks]);
+    pool.run(chunks, [&](size_t task, size_t) {
+        size_t const first = task * detail::parallel_chunk;
+        size_t const last = n - first < detail::parallel_chunk ? n : first + detail::parallel_chunk;
+        size_t* out = res.data() + offsets[task];
+        // index is stored unconditionally and kept only if record matches
+        size_t buffer[256];
+        for (size_t i = first; i < last;) {
+            size_t const end = last - i < 256 ? last : i + 256;
+            size_t k = 0;
+            for (; i < end; ++i) {
+                buffer[k] = i;
+                k += detail::test_raw<Pred, bytes>(detail::storage_access::data(data[i]), m);
+            }
+            std::copy(buffer, buffer + k, out);
+            out += k;
+        }
+    });
+    return res;
+}
+
+//!
+//! Combines all records with bitwise OR.
+//! @param data array of flags.
+//! @param n number of records.
+//! @param pool threads to run on.
+//! @returns flags set in at least one record.
+//!
+template<typename... Args>
+typed_flags<Args...> parallel_reduce_or(typed_flags<Args...> const* data, size_t n, thread_pool& pool = thread_pool::instance())
+{
+    typedef typed_flags<Args...> flags_type;
+    detail::partials<flags_type> acc(pool.size(), flags_type{});
+    pool.run(detail::chunk_count(n), [&](size_t task, size_t thread) {
+        size_t const first = task * detail::parallel_chunk;
+        size_t const last = n - first < detail::parallel_chunk ? n : first + detail::parallel_chunk;
+        flags_type res = acc[thread];
+        for (size_t i = first; i < last; ++i)
+            res |= data[i];
+        acc[thread] = res;
+    });
+    flags_type res;
+    for (size_t t = 0; t < pool.size(); ++t)
+        res |= acc[t];
+    return res;
+}
+
+//!
+//! Combines all records with bitwise AND.
+//! @param data array of flags.
+//! @param n number of records.
+//! @param pool threads to run on.
+//! @returns flags set in every record, all flags if array is empty.
+//!
+template<typename... Args>
+typed_flags<Args...> parallel_reduce_and(typed_flags<Args...> const* data, size_t n, thread_pool& pool = thread_pool::instance())
+{
+    typedef typed_flags<Args...> flags_type;
+    detail::partials<flags_type> acc(pool.size(), ~flags_type{});
+    pool.run(detail::chunk_count(n), [&](size_t task, size_t thread) {
+        size_t const first = task * detail::parallel_chunk;
+        size_t const last = n - first < detail::parallel_chunk ? n : first + detail::parallel_chunk;
+        flags_type res = acc[thread];
+        for (size_t i = first; i < last; ++i)
+            res &= data[i];
+        acc[thread] = res;
+    });
+    flags_type res = ~flags_type{};
+    for (size_t t = 0; t < pool.size(); ++t)
+        res &= acc[t];
+    return res;
+}
+
+//!
+//! Counts records per combination of specified flags.
+//! @param T... flag types, at most 16.
+//! @param data array of flags.
+//! @param n number of records.
+//! @param pool threads to run on.
+//! @returns counts indexed by combination, bit k of index is the value of k-th flag.
+//!
+template<typename... T, typename... Args>
+std::array<size_t, size_t(1) << sizeof...(T)>
+parallel_histogram(typed_flags<Args...> const* data, size_t n, thread_pool& pool = thread_pool::instance())
+{
+    static_assert(sizeof...(T) <= 16, "Histogram supports at most 16 flags");
+    typedef typed_flags<Args...> flags_type;
+    typedef std::array<size_t, size_t(1) << sizeof...(T)> histogram;
+    size_t const index[] = {flags_type::template index<T>()..., 0};
+
+    detail::partials<histogram> acc(pool.size(), histogram{});
+    pool.run(detail::chunk_count(n), [&](size_t task, size_t thread) {
+        size_t const first = task * detail::parallel_chunk;
+        size_t const last = n - first < detail::parallel_chunk ? n : first + detail::parallel_chunk;
+        auto& h = acc[thread];
+        for (size_t i = first; i < last; ++i) {
+            uint8_t const* const record = detail::storage_access::data(data[i]);
+            size_t combination = 0;
+            for (size_t k = 0; k < sizeof...(T); ++k)
+                combination |= size_t((record[index[k] / 8] >> (index[k] % 8)) & 1) << k;
+            ++h[combination];
+        }
+    });
+    histogram res{};
+    for (size_t t = 0; t < pool.size(); ++t)
+        for (size_t c = 0; c < res.size(); ++c)
+            res[c] += acc[t][c];
+    return res;
+}
+
+//! @}
+
+} // namespace tfl
+
+#endif
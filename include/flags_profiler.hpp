@@ -0,0 +1,220 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_PROFILER_HPP_
+#define _TFL_FLAGS_PROFILER_HPP_
+
+#include "typed_flags.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace tfl
+{
+
+template<typename Flags>
+class flags_profiler;
+
+//!
+//! @brief Hook counting typed accesses to every flag.
+//!
+//! Counters live in thread-local cache-line aligned blocks, so counting
+//! doesn't contend between threads. Counts of finished threads are kept.
+//! Enable it for a flags type by specializing flags_hook:
+//! @code
+//! namespace tfl {
+//! template<> struct flags_hook<animal>: flags_profiler<animal> {};
+//! }
+//! @endcode
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class flags_profiler<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //!
+    //! Number of counted operations, see flag_op.
+    //!
+    static constexpr size_t op_count = size_t(flag_op::query) + 1;
+
+    //!
+    //! @brief Access counters of a single flag.
+    //!
+    struct entry
+    {
+        size_t index;
+        std::array<uint64_t, op_count> counts;
+
+        uint64_t count(flag_op op) const noexcept
+        {
+            return counts[size_t(op)];
+        }
+
+        uint64_t total() const noexcept
+        {
+            uint64_t res = 0;
+            for (auto c : counts)
+                res += c;
+            return res;
+        }
+    };
+
+private:
+
+    // Counters are written by the owning thread only, relaxed atomics
+    // let other threads read them while collecting
+    struct alignas(64) block
+    {
+        std::atomic<uint64_t> counts[sizeof...(Args) + 1][op_count];
+
+        block()
+        {
+            for (auto& flag_counts : counts)
+                for (auto& c : flag_counts)
+                    c.store(0, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            registry().blocks.push_back(this);
+        }
+
+        ~block()
+        {
+            auto& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            add_to(reg.finished, *this);
+            reg.blocks.erase(std::find(reg.blocks.begin(), reg.blocks.end(), this));
+        }
+    };
+
+    struct registry_type
+    {
+        std::mutex mutex;
+        std::vector<block*> blocks;
+        std::array<std::array<uint64_t, op_count>, sizeof...(Args) + 1> finished{};
+    };
+
+    static registry_type& registry()
+    {
+        static registry_type reg;
+        return reg;
+    }
+
+    static block& local()
+    {
+        thread_local block b;
+        return b;
+    }
+
+    template<typename Totals>
+    static void add_to(Totals& totals, block const& b) noexcept
+    {
+        for (size_t i = 0; i < sizeof...(Args); ++i)
+            for (size_t op = 0; op < op_count; ++op)
+                totals[i][op] += b.counts[i][op].load(std::memory_order_relaxed);
+    }
+
+    static void increment(std::atomic<uint64_t>& c) noexcept
+    {
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+public:
+
+    //!
+    //! Counts access to flags, called by typed_flags via flags_hook.
+    //! @param Op operation.
+    //! @param T... accessed flag types.
+    //!
+    template<flag_op Op, typename... T>
+    static void on_access() noexcept
+    {
+        auto& b = local();
+        size_t const index[] = {flags_type::template index<T>()..., sizeof...(Args)};
+        for (size_t i = 0; i < sizeof...(T); ++i)
+            increment(b.counts[index[i]][size_t(Op)]);
+    }
+
+    //! @name Reports
+    //! @{
+
+    //!
+    //! Collects counters of all threads.
+    //! @returns entries of all flags sorted by total number of accesses, hottest first.
+    //!
+    static std::vector<entry> hottest()
+    {
+        std::array<std::array<uint64_t, op_count>, sizeof...(Args) + 1> totals;
+        {
+            auto& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            totals = reg.finished;
+            for (auto b : reg.blocks)
+                add_to(totals, *b);
+        }
+        std::vector<entry> res;
+        for (size_t i = 0; i < sizeof...(Args); ++i)
+            res.push_back(entry{i, totals[i]});
+        std::stable_sort(res.begin(), res.end(), [](entry const& a, entry const& b) {
+            return a.total() > b.total();
+        });
+        return res;
+    }
+
+    //!
+    //! Collects counters of the specified flag.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    static entry get()
+    {
+        for (auto const& e : hottest()) {
+            if (e.index == flags_type::template index<T>())
+                return e;
+        }
+        return entry{};
+    }
+
+    //!
+    //! Writes table of counters sorted by hotness, one flag per line.
+    //! @param os output stream.
+    //!
+    static void dump(std::ostream& os)
+    {
+        os << "index\ttest\tset\treset\tflip\tquery\ttotal\n";
+        for (auto const& e : hottest()) {
+            os << e.index;
+            for (auto c : e.counts)
+                os << '\t' << c;
+            os << '\t' << e.total() << '\n';
+        }
+    }
+
+    //!
+    //! Zeroes counters of all threads.<br> Should not run concurrently with counting.
+    //!
+    static void reset()
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.finished = {};
+        for (auto b : reg.blocks)
+            for (auto& flag_counts : b->counts)
+                for (auto& c : flag_counts)
+                    c.store(0, std::memory_order_relaxed);
+    }
+
+    //! @}
+};
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,182 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_QUERY_HPP_
+#define _TFL_FLAGS_QUERY_HPP_
+
+#include "typed_flags.hpp"
+#include "detail/bits.hpp"
+#include <array>
+#include <cstdint>
+
+namespace tfl
+{
+
+//!
+//! @brief Predicate satisfied when every specified flag is set.
+//! @param T... flag types.
+//!
+template<typename... T>
+struct all_of
+{
+    static constexpr bool conjunctive = true;
+    static constexpr bool inverted = false;
+
+    template<typename Flags>
+    static bool test(Flags const& flags) noexcept
+    {
+        return flags.template all<T...>();
+    }
+
+    template<typename W>
+    static bool test_word(W word, W mask) noexcept
+    {
+        return (word & mask) == mask;
+    }
+};
+
+//!
+//! @brief Predicate satisfied when at least one of specified flags is set.
+//! @param T... flag types.
+//!
+template<typename... T>
+struct any_of
+{
+    static constexpr bool conjunctive = false;
+    static constexpr bool inverted = false;
+
+    template<typename Flags>
+    static bool test(Flags const& flags) noexcept
+    {
+        return flags.template any<T...>();
+    }
+
+    template<typename W>
+    static bool test_word(W word, W mask) noexcept
+    {
+        return (word & mask) != 0;
+    }
+};
+
+//!
+//! @brief Predicate satisfied when every specified flag is unset.
+//! @param T... flag types.
+//!
+template<typename... T>
+struct none_of
+{
+    static constexpr bool conjunctive = true;
+    static constexpr bool inverted = true;
+
+    template<typename Flags>
+    static bool test(Flags const& flags) noexcept
+    {
+        return flags.template none<T...>();
+    }
+
+    template<typename W>
+    static bool test_word(W word, W mask) noexcept
+    {
+        return (word & mask) == 0;
+    }
+};
+
+//!
+//! @brief Modification setting specified flags.
+//! @param T... flag types.
+//!
+template<typename... T>
+struct set_flags
+{};
+
+//!
+//! @brief Modification unsetting specified flags.
+//! @param T... flag types.
+//!
+template<typename... T>
+struct reset_flags
+{};
+
+namespace detail
+{
+
+//
+// Returns flags with bits of specified types set.
+//
+template<typename Flags, typename... T>
+Flags flags_mask() noexcept
+{
+    return Flags(flag<T>{true}...);
+}
+
+//
+// Returns flags with bits of types listed in predicate or modification.
+//
+template<typename Flags, typename List>
+struct list_mask;
+
+template<typename Flags, template<typename...> class List, typename... T>
+struct list_mask<Flags, List<T...>>
+{
+    static Flags get() noexcept
+    {
+        return flags_mask<Flags, T...>();
+    }
+};
+
+//
+// Returns indexes of types listed in predicate or modification.
+//
+template<typename Flags, typename List>
+struct list_indices;
+
+template<typename Flags, template<typename...> class List, typename... T>
+struct list_indices<Flags, List<T...>>
+{
+    static constexpr size_t size = sizeof...(T);
+
+    static std::array<size_t, sizeof...(T)> get() noexcept
+    {
+        return {{Flags::template index<T>()...}};
+    }
+};
+
+//
+// Evaluates predicate over word of per-flag bitmaps, bit r of the
+// result tells whether row r matches. Planes are listed in predicate order.
+//
+template<typename Pred>
+uint64_t combine_planes(uint64_t const* const* planes, size_t count, size_t word) noexcept
+{
+    uint64_t const invert = Pred::inverted ? ~uint64_t(0) : 0;
+    uint64_t res = Pred::conjunctive ? ~uint64_t(0) : 0;
+    for (size_t k = 0; k < count; ++k) {
+        uint64_t const w = planes[k][word] ^ invert;
+        res = Pred::conjunctive ? (res & w) : (res | w);
+    }
+    return res;
+}
+
+//
+// Evaluates predicate over raw storage bytes of a record without branches.
+//
+template<typename Pred, size_t Bytes>
+bool test_raw(uint8_t const* record, uint8_t const* mask) noexcept
+{
+    bool res = Pred::conjunctive;
+    for (size_t offset = 0; offset < Bytes; offset += 8) {
+        size_t const n = Bytes - offset < 8 ? Bytes - offset : 8;
+        bool const t = Pred::test_word(load_le(record + offset, n), load_le(mask + offset, n));
+        res = Pred::conjunctive ? (res & t) : (res | t);
+    }
+    return res;
+}
+
+} // namespace detail
+
+} // namespace tfl
+
+#endif
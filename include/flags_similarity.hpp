@@ -0,0 +1,335 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_SIMILARITY_HPP_
+#define _TFL_FLAGS_SIMILARITY_HPP_
+
+#include "typed_flags.hpp"
+#include "flags_query.hpp"
+#include "detail/bits.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if (defined(__AVX512VPOPCNTDQ__) && defined(__AVX512BW__)) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace tfl
+{
+
+//!
+//! @brief Result of comparison of query with a record.
+//!
+struct similarity_match
+{
+    size_t index;       //!< record index
+    uint32_t common;    //!< number of flags set in both
+    uint32_t differ;    //!< number of flags set in one of them, Hamming distance
+
+    //!
+    //! Get the Jaccard similarity, 1 if neither has flags set.
+    //!
+    double jaccard() const noexcept
+    {
+        return common + differ ? double(common) / double(common + differ) : 1.0;
+    }
+};
+
+//!
+//! @brief Ranks by Hamming distance, the smallest first.
+//!
+struct hamming_metric
+{
+    static bool better(similarity_match const& a, similarity_match const& b) noexcept
+    {
+        return a.differ != b.differ ? a.differ < b.differ : a.index < b.index;
+    }
+};
+
+//!
+//! @brief Ranks by Jaccard similarity, the largest first.
+//!
+struct jaccard_metric
+{
+    static bool better(similarity_match const& a, similarity_match const& b) noexcept
+    {
+        // compare fractions exactly, empty union counts as identity
+        uint64_t const au = a.common + a.differ, bu = b.common + b.differ;
+        uint64_t const l = (au ? a.common : 1) * (bu ? bu : 1);
+        uint64_t const r = (bu ? b.common : 1) * (au ? au : 1);
+        return l != r ? l > r : a.index < b.index;
+    }
+};
+
+namespace detail
+{
+
+//
+// Counts bits of record set in both, and in any of query and record
+// within mask. Query is pre-masked. Bits past Bytes are ignored.
+//
+template<size_t Bytes>
+struct similarity_kernel
+{
+    static constexpr size_t words = (Bytes + 7) / 8;
+
+    uint64_t query[words + 1];
+    uint64_t mask[words + 1];
+
+    similarity_kernel(uint8_t const* q, uint8_t const* m) noexcept
+    {
+        for (size_t w = 0; w < words; ++w) {
+            size_t const n = Bytes - w * 8 < 8 ? Bytes - w * 8 : 8;
+            mask[w] = load_le(m + w * 8, n);
+            query[w] = load_le(q + w * 8, n) & mask[w];
+        }
+    }
+
+    // Reads only the record bytes
+    void count(uint8_t const* record, uint32_t& common, uint32_t& unite) const noexcept
+    {
+        uint32_t c = 0, u = 0;
+        for (size_t w = 0; w < words; ++w) {
+            size_t const n = Bytes - w * 8 < 8 ? Bytes - w * 8 : 8;
+            uint64_t const r = load_le(record + w * 8, n) & mask[w];
+            c += popcount64(r & query[w]);
+            u += popcount64(r | query[w]);
+        }
+        common = c;
+        unite = u;
+    }
+};
+
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512BW__)
+
+//
+// Masked loads never touch bytes past the record, so every record
+// takes vector path.
+//
+template<size_t Bytes>
+struct similarity_simd
+{
+    static constexpr size_t chunks = (Bytes + 63) / 64;
+    // records of all sizes
+    static constexpr size_t overrun = 0;
+
+    __m512i query[chunks];
+    __m512i mask[chunks];
+    __mmask64 load[chunks];
+
+    similarity_simd(uint8_t const* q, uint8_t const* m) noexcept
+    {
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t const n = Bytes - c * 64 < 64 ? Bytes - c * 64 : 64;
+            load[c] = n == 64 ? ~__mmask64(0) : (__mmask64(1) << n) - 1;
+            mask[c] = _mm512_maskz_loadu_epi8(load[c], m + c * 64);
+            query[c] = _mm512_and_si512(_mm512_maskz_loadu_epi8(load[c], q + c * 64), mask[c]);
+        }
+    }
+
+    void count(uint8_t const* record, uint32_t& common, uint32_t& unite) const noexcept
+    {
+        __m512i c = _mm512_setzero_si512(), u = _mm512_setzero_si512();
+        for (size_t i = 0; i < chunks; ++i) {
+            __m512i const r = _mm512_and_si512(_mm512_maskz_loadu_epi8(load[i], record + i * 64), mask[i]);
+            c = _mm512_add_epi64(c, _mm512_popcnt_epi64(_mm512_and_si512(r, query[i])));
+            u = _mm512_add_epi64(u, _mm512_popcnt_epi64(_mm512_or_si512(r, query[i])));
+        }
+        common = sum(c);
+        unite = sum(u);
+    }
+
+    // Zero-masked extracts, plain ones start from undefined vectors
+    static uint32_t sum(__m512i v) noexcept
+    {
+        __m256i const s = _mm256_add_epi64(_mm512_maskz_extracti64x4_epi64(0xFF, v, 0), _mm512_maskz_extracti64x4_epi64(0xFF, v, 1));
+        __m128i const h = _mm_add_epi64(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+        return uint32_t(_mm_cvtsi128_si64(h) + _mm_extract_epi64(h, 1));
+    }
+};
+
+#elif defined(__AVX2__)
+
+//
+// Nibble lookup popcount of 32-byte vectors, loads read whole chunks,
+// so records whose last chunk crosses the end of array take scalar path.
+//
+template<size_t Bytes>
+struct similarity_simd
+{
+    static constexpr size_t chunks = (Bytes + 31) / 32;
+    static constexpr size_t overrun = chunks * 32 - Bytes;
+
+    __m256i query[chunks];
+    __m256i mask[chunks];
+
+    similarity_simd(uint8_t const* q, uint8_t const* m) noexcept
+    {
+        alignas(32) uint8_t qb[chunks * 32] = {}, mb[chunks * 32] = {};
+        memcpy(qb, q, Bytes);
+        memcpy(mb, m, Bytes);
+        for (size_t c = 0; c < chunks; ++c) {
+            mask[c] = _mm256_load_si256(reinterpret_cast<__m256i const*>(mb + c * 32));
+            query[c] = _mm256_and_si256(_mm256_load_si256(reinterpret_cast<__m256i const*>(qb + c * 32)), mask[c]);
+        }
+    }
+
+    static __m256i popcount8(__m256i v) noexcept
+    {
+        __m256i const table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                               0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        __m256i const low = _mm256_set1_epi8(0x0F);
+        __m256i const lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+        __m256i const hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        return _mm256_add_epi8(lo, hi);
+    }
+
+    static uint32_t sum(__m256i v) noexcept
+    {
+        __m256i const s = _mm256_sad_epu8(v, _mm256_setzero_si256());
+        __m128i const h = _mm_add_epi64(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+        return uint32_t(_mm_cvtsi128_si64(h) + _mm_extract_epi64(h, 1));
+    }
+
+    void count(uint8_t const* record, uint32_t& common, uint32_t& unite) const noexcept
+    {
+        // byte counters hold at most 8 * chunks, chunks are limited below
+        __m256i c = _mm256_setzero_si256(), u = _mm256_setzero_si256();
+        for (size_t i = 0; i < chunks; ++i) {
+            __m256i const r = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(record + i * 32)), mask[i]);
+            c = _mm256_add_epi8(c, popcount8(_mm256_and_si256(r, query[i])));
+            u = _mm256_add_epi8(u, popcount8(_mm256_or_si256(r, query[i])));
+        }
+        common = sum(c);
+        unite = sum(u);
+    }
+
+    static_assert(chunks * 8 < 256, "Too many flags for byte counters");
+};
+
+#endif
+
+//
+// Calls fn(index, common, unite) for every record.
+//
+template<size_t Bytes, typename Fn>
+void for_each_similarity(uint8_t const* query, uint8_t const* mask, uint8_t const* records, size_t stride, size_t n, Fn&& fn)
+{
+    size_t i = 0;
+    uint32_t common, unite;
+#if (defined(__AVX512VPOPCNTDQ__) && defined(__AVX512BW__)) || defined(__AVX2__)
+    similarity_simd<Bytes> const simd(query, mask);
+    // the last records may need scalar path to stay within array
+    size_t const overrun_records = (similarity_simd<Bytes>::overrun + stride - 1) / stride;
+    size_t const vector_records = n > overrun_records ? n - overrun_records : 0;
+    for (; i < vector_records; ++i) {
+        simd.count(records + i * stride, common, unite);
+        fn(i, common, unite);
+    }
+#endif
+    similarity_kernel<Bytes> const scalar(query, mask);
+    for (; i < n; ++i) {
+        scalar.count(records + i * stride, common, unite);
+        fn(i, common, unite);
+    }
+}
+
+//
+// Returns mask of specified flags, all flags if none is specified.
+//
+template<typename Flags, typename... T>
+Flags similarity_mask() noexcept
+{
+    return sizeof...(T) ? flags_mask<Flags, T...>() : ~Flags{};
+}
+
+} // namespace detail
+
+//! @name Similarity
+//! @{
+
+//!
+//! Get the number of flags set in one of a and b only.
+//! @param T... flag types to compare, all flags if none is specified.
+//!
+template<typename... T, typename... Args>
+size_t hamming(typed_flags<Args...> const& a, typed_flags<Args...> const& b) noexcept
+{
+    typedef typed_flags<Args...> flags_type;
+    auto const mask = detail::similarity_mask<flags_type, T...>();
+    detail::similarity_kernel<detail::storage_access::bytes<flags_type>()> const k(detail::storage_access::data(a), detail::storage_access::data(mask));
+    uint32_t common, unite;
+    k.count(detail::storage_access::data(b), common, unite);
+    return unite - common;
+}
+
+//!
+//! Get the Jaccard similarity, the number of flags set in both a and b
+//! divided by the number of flags set in any of them, 1 if none is set.
+//! @param T... flag types to compare, all flags if none is specified.
+//!
+template<typename... T, typename... Args>
+double jaccard(typed_flags<Args...> const& a, typed_flags<Args...> const& b) noexcept
+{
+    typedef typed_flags<Args...> flags_type;
+    auto const mask = detail::similarity_mask<flags_type, T...>();
+    detail::similarity_kernel<detail::storage_access::bytes<flags_type>()> const k(detail::storage_access::data(a), detail::storage_access::data(mask));
+    uint32_t common, unite;
+    k.count(detail::storage_access::data(b), common, unite);
+    return unite ? double(common) / double(unite) : 1.0;
+}
+
+//!
+//! Finds k records most similar to query keeping bounded heap of the best
+//! ones. Records are compared word by word, with AVX-512 VPOPCNTDQ or AVX2
+//! when available.
+//! @param Metric hamming_metric or jaccard_metric.
+//! @param T... flag types to compare, all flags if none is specified.
+//! @param query flags to compare records with.
+//! @param data array of flags.
+//! @param n number of records.
+//! @param k maximum number of results.
+//! @returns matches ordered from the most similar, ties by index.
+//!
+template<typename Metric, typename... T, typename... Args>
+std::vector<similarity_match> top_k_similar(typed_flags<Args...> const& query, typed_flags<Args...> const* data, size_t n, size_t k)
+{
+    typedef typed_flags<Args...> flags_type;
+    constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    auto const better = [](similarity_match const& a, similarity_match const& b) {
+        return Metric::better(a, b);
+    };
+
+    std::vector<similarity_match> heap;
+    if (k == 0)
+        return heap;
+    heap.reserve(k < n ? k : n);
+    auto const mask = detail::similarity_mask<flags_type, T...>();
+    // heap front is the worst of the best
+    detail::for_each_similarity<bytes>(detail::storage_access::data(query), detail::storage_access::data(mask),
+                                       reinterpret_cast<uint8_t const*>(data), sizeof(flags_type), n,
+                                       [&](size_t i, uint32_t common, uint32_t unite) {
+        similarity_match const m{i, common, unite - common};
+        if (heap.size() < k) {
+            heap.push_back(m);
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+        else if (better(m, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = m;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    });
+    std::sort_heap(heap.begin(), heap.end(), better);
+    return heap;
+}
+
+//! @}
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,438 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_SNAPSHOT_TABLE_HPP_
+#define _TFL_FLAGS_SNAPSHOT_TABLE_HPP_
+
+#include "typed_flags.hpp"
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace tfl
+{
+
+//!
+//! @brief Table of flags with wait-free snapshot readers and single writer.
+//!
+//! Rows are split into chunks. Writer batches changes into a new version
+//! which copies only modified chunks and shares the rest with the previous one.
+//! Versions are published atomically and reclaimed in epoch-based manner
+//! when no reader can observe them.
+//! @param Flags typed_flags type of rows.
+//! @param ChunkSize number of rows in a chunk.
+//!
+template<typename Flags, size_t ChunkSize = 256>
+class flags_snapshot_table
+{
+    static_assert(ChunkSize > 0, "Chunk can't be empty");
+
+    struct chunk
+    {
+        // Number of versions referring to this chunk, touched by writer only
+        size_t refs;
+        Flags rows[ChunkSize];
+    };
+
+    struct version
+    {
+        size_t size;
+        std::vector<chunk*> chunks;
+    };
+
+    struct alignas(64) reader_slot
+    {
+        // Epoch observed by active snapshot, zero if there is no one
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> used{true};
+        reader_slot* next = nullptr;
+    };
+
+public:
+
+    class reader;
+    class update;
+
+    //!
+    //! @brief Consistent read-only view of the table.
+    //!
+    //! Holding snapshot for a long time delays reclamation of old versions.
+    //!
+    class snapshot
+    {
+        friend class reader;
+
+        snapshot(reader_slot* slot, version const* v) noexcept
+            : m_slot(slot), m_version(v)
+        {}
+
+    public:
+
+        snapshot(snapshot&& other) noexcept
+            : m_slot(other.m_slot), m_version(other.m_version)
+        {
+            other.m_slot = nullptr;
+        }
+
+        snapshot& operator = (snapshot&&) = delete;
+
+        ~snapshot()
+        {
+            if (m_slot)
+                m_slot->epoch.store(0, std::memory_order_release);
+        }
+
+        //!
+        //! Get the number of rows.
+        //!
+        size_t size() const noexcept
+        {
+            return m_version->size;
+        }
+
+        //!
+        //! Returns flags of the row.
+        //! @param row row index less than size().
+        //!
+        Flags const& operator [] (size_t row) const noexcept
+        {
+            return m_version->chunks[row / ChunkSize]->rows[row % ChunkSize];
+        }
+
+        //!
+        //! Returns the value of the specified flag in the row.
+        //! @param T flag type.
+        //! @param row row index.
+        //!
+        template<typename T>
+        bool test(size_t row) const noexcept
+        {
+            return (*this)[row].template test<T>();
+        }
+
+        //!
+        //! Checks that every specified flag is set in the row.
+        //! @param T... flag types.
+        //! @param row row index.
+        //!
+        template<typename... T>
+        bool all(size_t row) const noexcept
+        {
+            return (*this)[row].template all<T...>();
+        }
+
+        //!
+        //! Checks that at least one of specified flags is set in the row.
+        //! @param T... flag types.
+        //! @param row row index.
+        //!
+        template<typename... T>
+        bool any(size_t row) const noexcept
+        {
+            return (*this)[row].template any<T...>();
+        }
+
+        //!
+        //! Checks that every specified flag is unset in the row.
+        //! @param T... flag types.
+        //! @param row row index.
+        //!
+        template<typename... T>
+        bool none(size_t row) const noexcept
+        {
+            return (*this)[row].template none<T...>();
+        }
+
+    private:
+
+        reader_slot* m_slot;
+        version const* m_version;
+    };
+
+    //!
+    //! @brief Per-thread handle used to take snapshots.
+    //!
+    //! Each handle supports one live snapshot at a time.
+    //! Handles must be destroyed before the table.
+    //!
+    class reader
+    {
+        friend class flags_snapshot_table;
+
+        reader(flags_snapshot_table const& table, reader_slot* slot) noexcept
+            : m_table(&table), m_slot(slot)
+        {}
+
+    public:
+
+        reader(reader&& other) noexcept
+            : m_table(other.m_table), m_slot(other.m_slot)
+        {
+            other.m_slot = nullptr;
+        }
+
+        reader& operator = (reader&&) = delete;
+
+        ~reader()
+        {
+            if (m_slot)
+                m_slot->used.store(false, std::memory_order_release);
+        }
+
+        //!
+        //! Takes consistent snapshot of the table. Wait-free.
+        //!
+        snapshot acquire() const noexcept
+        {
+            // Epoch is announced before reading the version, so writer
+            // never reclaims a version this reader can still observe
+            m_slot->epoch.store(m_table->m_epoch.load());
+            return snapshot(m_slot, m_table->m_current.load());
+        }
+
+    private:
+
+        flags_snapshot_table const* m_table;
+        reader_slot* m_slot;
+    };
+
+    //!
+    //! @brief Batch of changes forming the next version.
+    //!
+    //! Only one update can exist at a time. Changes become visible to readers
+    //! on commit(), destroying uncommitted update discards them.
+    //!
+    class update
+    {
+        friend class flags_snapshot_table;
+
+        explicit update(flags_snapshot_table& table)
+            : m_table(&table),
+              m_version(new version(*table.m_current.load())),
+              m_owned(m_version->chunks.size(), false)
+        {
+            for (auto c : m_version->chunks)
+                ++c->refs;
+        }
+
+    public:
+
+        update(update&& other) noexcept
+            : m_table(other.m_table),
+              m_version(other.m_version),
+              m_owned(std::move(other.m_owned))
+        {
+            other.m_version = nullptr;
+        }
+
+        update& operator = (update&&) = delete;
+
+        ~update()
+        {
+            if (m_version)
+                release(m_version);
+        }
+
+        //!
+        //! Get the number of rows.
+        //!
+        size_t size() const noexcept
+        {
+            return m_version->size;
+        }
+
+        //!
+        //! Returns flags of the row including uncommitted changes.
+        //! @param row row index less than size().
+        //!
+        Flags const& operator [] (size_t row) const noexcept
+        {
+            return m_version->chunks[row / ChunkSize]->rows[row % ChunkSize];
+        }
+
+        //!
+        //! Sets specified flags in the row.
+        //! @param T... flag types.
+        //! @param row row index.
+        //!
+        template<typename... T>
+        void set(size_t row)
+        {
+            modify(row).template set<T...>();
+        }
+
+        //!
+        //! Unsets specified flags in the row.
+        //! @param T... flag types.
+        //! @param row row index.
+        //!
+        template<typename... T>
+        void reset(size_t row)
+        {
+            modify(row).template reset<T...>();
+        }
+
+        //!
+        //! Replaces all flags of the row.
+        //! @param row row index.
+        //! @param flags new value.
+        //!
+        void assign(size_t row, Flags const& flags)
+        {
+            modify(row) = flags;
+        }
+
+        //!
+        //! Publishes changes to readers and reclaims unobservable versions.
+        //!
+        void commit()
+        {
+            m_table->publish(m_version);
+            m_version = nullptr;
+        }
+
+    private:
+
+        // Copies chunk on first modification within this update
+        Flags& modify(size_t row)
+        {
+            size_t const k = row / ChunkSize;
+            chunk*& c = m_version->chunks[k];
+            if (!m_owned[k]) {
+                chunk* copy = new chunk(*c);
+                copy->refs = 1;
+                --c->refs;
+                c = copy;
+                m_owned[k] = true;
+            }
+            return c->rows[row % ChunkSize];
+        }
+
+        flags_snapshot_table* m_table;
+        version* m_version;
+        std::vector<bool> m_owned;
+    };
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Creates table of rows with all flags set to zero.
+    //! @param rows number of rows.
+    //!
+    explicit flags_snapshot_table(size_t rows)
+        : m_current(nullptr), m_epoch(1), m_readers(nullptr)
+    {
+        version* v = new version{rows, {}};
+        v->chunks.reserve(rows / ChunkSize + 1);
+        for (size_t i = 0; i < rows; i += ChunkSize) {
+            v->chunks.push_back(new chunk);
+            v->chunks.back()->refs = 1;
+        }
+        m_current.store(v);
+    }
+
+    flags_snapshot_table(flags_snapshot_table const&) = delete;
+    flags_snapshot_table& operator = (flags_snapshot_table const&) = delete;
+
+    //!
+    //! Frees all versions. There must be no readers left.
+    //!
+    ~flags_snapshot_table()
+    {
+        for (auto& r : m_retired)
+            release(r.first);
+        release(m_current.load());
+        for (reader_slot* s = m_readers.load(); s;) {
+            reader_slot* next = s->next;
+            delete s;
+            s = next;
+        }
+    }
+
+    //! @}
+    //! @name Access
+    //! @{
+
+    //!
+    //! Creates reader handle for the calling thread.
+    //!
+    reader make_reader() const
+    {
+        for (reader_slot* s = m_readers.load(); s; s = s->next) {
+            bool expected = false;
+            if (!s->used.load() && s->used.compare_exchange_strong(expected, true))
+                return reader(*this, s);
+        }
+        reader_slot* s = new reader_slot;
+        s->next = m_readers.load();
+        while (!m_readers.compare_exchange_weak(s->next, s))
+            ;
+        return reader(*this, s);
+    }
+
+    //!
+    //! Starts a batch of changes. Must be called by the single writer.
+    //!
+    update begin_update()
+    {
+        return update(*this);
+    }
+
+    //! @}
+
+private:
+
+    static void release(version* v)
+    {
+        for (auto c : v->chunks) {
+            if (--c->refs == 0)
+                delete c;
+        }
+        delete v;
+    }
+
+    void publish(version* v)
+    {
+        version* old = m_current.exchange(v);
+        uint64_t const epoch = m_epoch.fetch_add(1) + 1;
+        m_retired.emplace_back(old, epoch);
+        reclaim();
+    }
+
+    //
+    // Frees versions retired no later than the oldest epoch announced by readers.
+    // Reader announcing an epoch at least equal to the retire epoch has
+    // loaded the version pointer after it was replaced.
+    //
+    void reclaim()
+    {
+        uint64_t oldest = uint64_t(-1);
+        for (reader_slot* s = m_readers.load(); s; s = s->next) {
+            uint64_t const e = s->epoch.load();
+            if (e != 0 && e < oldest)
+                oldest = e;
+        }
+        size_t kept = 0;
+        for (auto& r : m_retired) {
+            if (r.second <= oldest)
+                release(r.first);
+            else
+                m_retired[kept++] = r;
+        }
+        m_retired.resize(kept);
+    }
+
+    std::atomic<version*> m_current;
+    std::atomic<uint64_t> m_epoch;
+    mutable std::atomic<reader_slot*> m_readers;
+    std::vector<std::pair<version*, uint64_t>> m_retired;
+};
+
+} // namespace tfl
+
+#endif
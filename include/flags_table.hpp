@@ -0,0 +1,291 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_TABLE_HPP_
+#define _TFL_FLAGS_TABLE_HPP_
+
+#include "typed_flags.hpp"
+#include "flags_query.hpp"
+#include "detail/bits.hpp"
+#include "detail/partials.hpp"
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace tfl
+{
+
+template<typename Flags>
+class flags_table;
+
+//!
+//! @brief Array of flags keeping population counts up to date.
+//!
+//! Every modification adjusts the number of rows per flag and, for up to
+//! max_combination_flags flags, per combination of flag values, so counting
+//! queries don't scan rows. Counters are split into shards picked by thread
+//! to keep concurrent writers off each other's cache lines.
+//!
+//! Different rows may be modified concurrently, the same row may not.
+//! Counts read during modifications reflect some of them.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class flags_table<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //!
+    //! Maximum number of flags for which combinations are counted.
+    //!
+    static constexpr size_t max_combination_flags = 10;
+
+    //!
+    //! Tells whether count_combination() is available.
+    //!
+    static constexpr bool has_combinations = sizeof...(Args) <= max_combination_flags;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Creates table of rows with all flags unset.
+    //! @param rows number of rows.
+    //! @param shards number of counter shards (optional).
+    //!
+    explicit flags_table(size_t rows = 0, size_t shards = default_shards())
+        : m_rows(rows), m_shard_count(shards ? shards : 1), m_shards(m_shard_count)
+    {
+        if (has_combinations)
+            m_shards[0].combinations[0].store(int64_t(rows), std::memory_order_relaxed);
+    }
+
+    //!
+    //! Creates table of specified rows.
+    //! @param rows flags of rows.
+    //! @param shards number of counter shards (optional).
+    //!
+    explicit flags_table(std::vector<flags_type> rows, size_t shards = default_shards())
+        : m_rows(std::move(rows)), m_shard_count(shards ? shards : 1), m_shards(m_shard_count)
+    {
+        auto& s = m_shards[0];
+        for (auto const& row : m_rows) {
+            detail::for_each_set_bit(detail::storage_access::data(row), bytes, [&](size_t i) {
+                s.counts[i].fetch_add(1, std::memory_order_relaxed);
+            });
+            if (has_combinations)
+                s.combinations[combination(row)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    flags_table(flags_table const&) = delete;
+    flags_table& operator = (flags_table const&) = delete;
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Get the number of rows.
+    //!
+    size_t size() const noexcept
+    {
+        return m_rows.size();
+    }
+
+    //!
+    //! Returns flags of the row.
+    //! @param row row index less than size().
+    //!
+    flags_type const& operator [] (size_t row) const noexcept
+    {
+        return m_rows[row];
+    }
+
+    //!
+    //! Returns the value of the specified flag in the row.
+    //! @param T flag type.
+    //! @param row row index less than size().
+    //!
+    template<typename T>
+    bool test(size_t row) const noexcept
+    {
+        return m_rows[row].template test<T>();
+    }
+
+    //! @}
+    //! @name Modifiers
+    //! @{
+
+    //!
+    //! Sets specified flags in the row.
+    //! @param T... flag types.
+    //! @param row row index less than size().
+    //!
+    template<typename... T>
+    void set(size_t row) noexcept
+    {
+        flags_type value = m_rows[row];
+        value.template set<T...>();
+        assign(row, value);
+    }
+
+    //!
+    //! Unsets specified flags in the row.
+    //! @param T... flag types.
+    //! @param row row index less than size().
+    //!
+    template<typename... T>
+    void reset(size_t row) noexcept
+    {
+        flags_type value = m_rows[row];
+        value.template reset<T...>();
+        assign(row, value);
+    }
+
+    //!
+    //! Replaces flags of the row.
+    //! @param row row index less than size().
+    //! @param value new flags.
+    //!
+    void assign(size_t row, flags_type const& value) noexcept
+    {
+        flags_type const old = m_rows[row];
+        flags_type const changed = old ^ value;
+        if (changed.none())
+            return;
+        m_rows[row] = value;
+        auto& s = m_shards[local_shard()];
+        uint8_t const* const bits = detail::storage_access::data(value);
+        detail::for_each_set_bit(detail::storage_access::data(changed), bytes, [&](size_t i) {
+            s.counts[i].fetch_add((bits[i / 8] >> (i % 8)) & 1 ? 1 : -1, std::memory_order_relaxed);
+        });
+        if (has_combinations) {
+            s.combinations[combination(old)].fetch_sub(1, std::memory_order_relaxed);
+            s.combinations[combination(value)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    //! @}
+    //! @name Counting
+    //! @{
+
+    //!
+    //! Get the number of rows having flag set.
+    //! @param index flag index.
+    //!
+    size_t count(size_t index) const noexcept
+    {
+        int64_t res = 0;
+        for (size_t i = 0; i < m_shard_count; ++i)
+            res += m_shards[i].counts[index].load(std::memory_order_relaxed);
+        return size_t(res);
+    }
+
+    //!
+    //! Get the number of rows having the specified flag set.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    size_t count() const noexcept
+    {
+        return count(flags_type::template index<T>());
+    }
+
+    //!
+    //! Get the number of rows matching every predicate.
+    //! Combinations matching predicates are found once per predicate list,
+    //! then every call reads their counters in every shard, which takes
+    //! matching combinations times shards reads, 2^N times shards at most.
+    //! @param Preds... predicates: all_of, any_of or none_of.
+    //! @note Available when flags count doesn't exceed max_combination_flags.
+    //!
+    template<typename... Preds>
+    size_t count_combination() const noexcept
+    {
+        static_assert(has_combinations, "Too many flags to count combinations");
+        static matching<Preds...> const cells;
+        int64_t res = 0;
+        for (size_t k = 0; k < m_shard_count; ++k) {
+            auto const& s = m_shards[k];
+            for (size_t i = 0; i < cells.size; ++i)
+                res += s.combinations[cells.index[i]].load(std::memory_order_relaxed);
+        }
+        return size_t(res);
+    }
+
+    //! @}
+
+private:
+
+    static constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    static constexpr size_t combination_count = size_t(1) << (has_combinations ? sizeof...(Args) : 0);
+
+    // Counters are signed, a shard may see more resets than sets
+    struct shard
+    {
+        std::atomic<int64_t> counts[sizeof...(Args) ? sizeof...(Args) : 1];
+        std::atomic<int64_t> combinations[combination_count];
+    };
+
+    // Combinations matching every predicate
+    template<typename... Preds>
+    struct matching
+    {
+        matching() noexcept
+            : size(0)
+        {
+            uint64_t const masks[] = {0, mask_word<Preds>()...};
+            (void)masks;
+            for (size_t c = 0; c < combination_count; ++c) {
+                size_t i = 1;
+                bool match = true;
+                bool const _[] = {true, (match = match && Preds::test_word(uint64_t(c), masks[i++]))...};
+                (void)_;
+                if (match)
+                    index[size++] = uint16_t(c);
+            }
+        }
+
+        uint16_t index[combination_count];
+        size_t size;
+    };
+
+    static size_t default_shards() noexcept
+    {
+        size_t const n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+
+    size_t local_shard() const noexcept
+    {
+        thread_local size_t const id = std::hash<std::thread::id>()(std::this_thread::get_id());
+        return id % m_shard_count;
+    }
+
+    static size_t combination(flags_type const& value) noexcept
+    {
+        return size_t(detail::load_le(detail::storage_access::data(value), bytes < 8 ? bytes : 8));
+    }
+
+    template<typename Pred>
+    static uint64_t mask_word() noexcept
+    {
+        auto const mask = detail::list_mask<flags_type, Pred>::get();
+        return detail::load_le(detail::storage_access::data(mask), bytes < 8 ? bytes : 8);
+    }
+
+    std::vector<flags_type> m_rows;
+    size_t m_shard_count;
+    detail::partials<shard> m_shards;
+};
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,363 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_UPDATE_QUEUE_HPP_
+#define _TFL_FLAGS_UPDATE_QUEUE_HPP_
+
+#include "typed_flags.hpp"
+#include "flags_query.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tfl
+{
+
+template<typename Key, typename Flags, typename Hash = std::hash<Key>>
+class flags_update_queue;
+
+//!
+//! @brief Queue of flag modifications from many producers merged per key.
+//!
+//! Every producer handle owns a bounded single-producer ring, so pushing is
+//! lock-free and producers don't contend with each other. The single consumer
+//! drains all rings and merges modifications of the same key into one
+//! before handing them out, so the number of applied modifications depends
+//! on the number of distinct keys rather than events. Merging uses an open
+//! addressing table kept between drains, so steady state drains don't
+//! allocate and cost one probe sequence per event.
+//!
+//! Modifications of one key pushed by one producer are merged in push order,
+//! ones pushed by different producers are merged in unspecified order.
+//! @param Key key type, default constructible, copyable, hashable and equality comparable.
+//! @param Args... user defined types.
+//! @param Hash key hash function.
+//!
+template<typename Key, typename... Args, typename Hash>
+class flags_update_queue<Key, typed_flags<Args...>, Hash>
+{
+public:
+
+    typedef Key key_type;
+    typedef typed_flags<Args...> flags_type;
+
+    //!
+    //! @brief Modification setting and unsetting flags.
+    //!
+    //! Flags listed in both masks are unset, as in update_where().
+    //!
+    struct update
+    {
+        flags_type set;     //!< flags to set
+        flags_type clear;   //!< flags to unset, never intersects set
+
+        //!
+        //! Creates modification from flag lists.
+        //! @param set_flags<S...> flags to set.
+        //! @param reset_flags<R...> flags to unset.
+        //!
+        template<typename... S, typename... R>
+        static update of(set_flags<S...>, reset_flags<R...> = {}) noexcept
+        {
+            auto const clear = detail::flags_mask<flags_type, R...>();
+            return {detail::flags_mask<flags_type, S...>() & ~clear, clear};
+        }
+
+        //!
+        //! Creates modification unsetting flags.
+        //! @param reset_flags<R...> flags to unset.
+        //!
+        template<typename... R>
+        static update of(reset_flags<R...> reset) noexcept
+        {
+            return of(set_flags<>{}, reset);
+        }
+
+        //!
+        //! Returns modification equal to applying this one followed by next.
+        //! @param next modification applied later.
+        //!
+        update then(update const& next) const noexcept
+        {
+            return {(set & ~next.clear) | next.set, (clear & ~next.set) | next.clear};
+        }
+
+        //!
+        //! Modifies flags.
+        //! @param value flags to modify.
+        //!
+        void apply(flags_type& value) const noexcept
+        {
+            value = (value & ~clear) | set;
+        }
+    };
+
+private:
+
+    struct entry
+    {
+        Key key;
+        update value;
+    };
+
+    // Producer owns tail and consumer owns head, both increase without wrapping.
+    // Padding keeps them on different cache lines without over-aligned new
+    struct producer_slot
+    {
+        explicit producer_slot(size_t capacity)
+            : entries(new entry[capacity])
+        {}
+
+        std::atomic<size_t> tail{0};
+        uint8_t tail_padding[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> head{0};
+        uint8_t head_padding[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<bool> used{true};
+        producer_slot* next = nullptr;
+        std::unique_ptr<entry[]> entries;
+    };
+
+public:
+
+    //!
+    //! @brief Per-thread handle used to push modifications.
+    //!
+    //! Handles must be destroyed before the queue. Modifications pushed
+    //! through destroyed handle are still delivered.
+    //!
+    class producer
+    {
+        friend class flags_update_queue;
+
+        producer(flags_update_queue& queue, producer_slot* slot) noexcept
+            : m_queue(&queue), m_slot(slot)
+        {}
+
+    public:
+
+        producer(producer&& other) noexcept
+            : m_queue(other.m_queue), m_slot(other.m_slot)
+        {
+            other.m_slot = nullptr;
+        }
+
+        producer& operator = (producer&&) = delete;
+
+        ~producer()
+        {
+            if (m_slot)
+                m_slot->used.store(false, std::memory_order_release);
+        }
+
+        //!
+        //! Pushes modification if ring has room. Lock-free.
+        //! @param key key of modified entity.
+        //! @param value modification.
+        //! @returns false if ring is full.
+        //!
+        bool try_push(Key const& key, update const& value) noexcept(std::is_nothrow_copy_assignable<Key>::value)
+        {
+            size_t const tail = m_slot->tail.load(std::memory_order_relaxed);
+            if (tail - m_slot->head.load(std::memory_order_acquire) == m_queue->m_capacity)
+                return false;
+            entry& e = m_slot->entries[tail & (m_queue->m_capacity - 1)];
+            e.key = key;
+            e.value = value;
+            m_slot->tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        //!
+        //! Pushes modification, yields while ring is full.
+        //! @param key key of modified entity.
+        //! @param value modification.
+        //!
+        void push(Key const& key, update const& value)
+        {
+            while (!try_push(key, value))
+                std::this_thread::yield();
+        }
+
+        //!
+        //! Pushes modification setting and unsetting flags, yields while ring is full.
+        //! @param key key of modified entity.
+        //! @param set_flags<S...> flags to set.
+        //! @param reset_flags<R...> flags to unset.
+        //!
+        template<typename... S, typename... R>
+        void push(Key const& key, set_flags<S...> set, reset_flags<R...> reset = {})
+        {
+            push(key, update::of(set, reset));
+        }
+
+        //!
+        //! Pushes modification unsetting flags, yields while ring is full.
+        //! @param key key of modified entity.
+        //! @param reset_flags<R...> flags to unset.
+        //!
+        template<typename... R>
+        void push(Key const& key, reset_flags<R...> reset)
+        {
+            push(key, update::of(reset));
+        }
+
+    private:
+
+        flags_update_queue* m_queue;
+        producer_slot* m_slot;
+    };
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Creates empty queue.
+    //! @param capacity number of modifications each producer can buffer, rounded up to power of two.
+    //!
+    explicit flags_update_queue(size_t capacity = 4096)
+        : m_capacity(1), m_producers(nullptr)
+    {
+        while (m_capacity < capacity)
+            m_capacity <<= 1;
+    }
+
+    flags_update_queue(flags_update_queue const&) = delete;
+    flags_update_queue& operator = (flags_update_queue const&) = delete;
+
+    //!
+    //! Frees rings. There must be no producers left.
+    //!
+    ~flags_update_queue()
+    {
+        for (producer_slot* s = m_producers.load(); s;) {
+            producer_slot* next = s->next;
+            delete s;
+            s = next;
+        }
+    }
+
+    //! @}
+    //! @name Access
+    //! @{
+
+    //!
+    //! Creates producer handle for the calling thread.
+    //!
+    producer make_producer()
+    {
+        for (producer_slot* s = m_producers.load(); s; s = s->next) {
+            bool expected = false;
+            if (!s->used.load() && s->used.compare_exchange_strong(expected, true))
+                return producer(*this, s);
+        }
+        producer_slot* s = new producer_slot(m_capacity);
+        s->next = m_producers.load();
+        while (!m_producers.compare_exchange_weak(s->next, s))
+            ;
+        return producer(*this, s);
+    }
+
+    //!
+    //! Takes all pushed modifications and hands them out merged per key.
+    //! Must be called by the single consumer.
+    //! @param fn function accepting key and merged update, called once per distinct key.
+    //! @returns number of taken modifications.
+    //!
+    template<typename Fn>
+    size_t drain(Fn&& fn)
+    {
+        size_t taken = 0;
+        for (producer_slot* s = m_producers.load(std::memory_order_acquire); s; s = s->next) {
+            size_t const head = s->head.load(std::memory_order_relaxed);
+            size_t const tail = s->tail.load(std::memory_order_acquire);
+            for (size_t i = head; i != tail; ++i) {
+                entry const& e = s->entries[i & (m_capacity - 1)];
+                merge(e.key, e.value);
+            }
+            s->head.store(tail, std::memory_order_release);
+            taken += tail - head;
+        }
+        for (size_t i : m_merged)
+            fn(m_slots[i].key, m_slots[i].value);
+        next_stamp();
+        return taken;
+    }
+
+    //! @}
+
+private:
+
+    // Slot of merge table is taken in the current drain if its stamp is current
+    struct merge_slot
+    {
+        Key key;
+        update value;
+        uint32_t stamp = 0;
+    };
+
+    void merge(Key const& key, update const& value)
+    {
+        if ((m_merged.size() + 1) * 2 > m_slots.size())
+            grow();
+        size_t const mask = m_slots.size() - 1;
+        // Fibonacci hashing spreads identity hashes of integers
+        size_t i = size_t((uint64_t(m_hash(key)) * 0x9e3779b97f4a7c15ULL) >> (64 - m_slot_bits));
+        for (;; i = (i + 1) & mask) {
+            merge_slot& s = m_slots[i];
+            if (s.stamp != m_stamp) {
+                s.key = key;
+                s.value = value;
+                s.stamp = m_stamp;
+                m_merged.push_back(i);
+                return;
+            }
+            if (s.key == key) {
+                s.value = s.value.then(value);
+                return;
+            }
+        }
+    }
+
+    void grow()
+    {
+        std::vector<merge_slot> old(m_slots.empty() ? 64 : m_slots.size() * 2);
+        old.swap(m_slots);
+        m_slot_bits = m_slot_bits ? m_slot_bits + 1 : 6;
+        std::vector<size_t> merged;
+        merged.swap(m_merged);
+        m_merged.reserve(merged.size());
+        for (size_t i : merged)
+            merge(old[i].key, old[i].value);
+    }
+
+    // Frees all slots without visiting them
+    void next_stamp() noexcept
+    {
+        m_merged.clear();
+        if (++m_stamp == 0) {
+            for (auto& s : m_slots)
+                s.stamp = 0;
+            m_stamp = 1;
+        }
+    }
+
+    size_t m_capacity;
+    std::atomic<producer_slot*> m_producers;
+    // Merge table kept between drains, its size is a power of two
+    std::vector<merge_slot> m_slots;
+    std::vector<size_t> m_merged;
+    unsigned m_slot_bits = 0;
+    uint32_t m_stamp = 1;
+    Hash m_hash;
+};
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,268 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_FLAGS_WINDOW_HPP_
+#define _TFL_FLAGS_WINDOW_HPP_
+
+#include "typed_flags.hpp"
+#include "detail/bits.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+namespace tfl
+{
+
+template<typename Flags, size_t Buckets, typename Clock = std::chrono::steady_clock>
+class flags_window;
+
+//!
+//! @brief Aggregates of timestamped flags over sliding time window.
+//!
+//! Window consists of Buckets buckets of equal duration in a ring. Every
+//! bucket keeps the number of events, per-flag counters and OR/AND of its
+//! events, running totals are adjusted when events arrive and buckets expire,
+//! so queries never visit events. Window ends at the bucket of the latest
+//! event or advance() time, events older than the window are ignored.
+//! @param Args... user defined types.
+//! @param Buckets number of buckets.
+//! @param Clock clock of event timestamps, timestamps must not precede its epoch.
+//!
+template<typename... Args, size_t Buckets, typename Clock>
+class flags_window<typed_flags<Args...>, Buckets, Clock>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+    typedef Clock clock_type;
+    typedef typename Clock::duration duration;
+    typedef typename Clock::time_point time_point;
+
+    static_assert(Buckets > 0, "Window requires at least one bucket");
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Creates empty window.
+    //! @param bucket_width duration of bucket, window spans Buckets * bucket_width.
+    //! @throws std::invalid_argument if bucket width is not positive.
+    //!
+    explicit flags_window(duration bucket_width)
+        : m_width(bucket_width), m_head(-1), m_head_end(), m_events(0), m_totals{}
+    {
+        if (bucket_width <= duration::zero())
+            throw std::invalid_argument("Window bucket width must be positive");
+        for (auto& b : m_buckets)
+            clear(b);
+    }
+
+    //! @}
+    //! @name Modifiers
+    //! @{
+
+    //!
+    //! Accounts event, moves window forward if event is newer than its end.
+    //! @param time event timestamp.
+    //! @param flags event flags.
+    //!
+    void add(time_point time, flags_type const& flags) noexcept
+    {
+        bucket* b;
+        if (m_head >= 0 && time < m_head_end && time >= m_head_end - m_width) {
+            b = &m_buckets[size_t(m_head) % Buckets];
+        }
+        else {
+            int64_t const index = bucket_index(time);
+            if (index > m_head)
+                advance_to(index);
+            else if (index <= m_head - int64_t(Buckets))
+                return;
+            b = &m_buckets[size_t(index) % Buckets];
+        }
+        ++b->events;
+        ++m_events;
+        b->any |= flags;
+        b->all &= flags;
+        detail::for_each_set_bit(detail::storage_access::data(flags), bytes, [&](size_t i) {
+            ++b->counts[i];
+            ++m_totals[i];
+        });
+    }
+
+    //!
+    //! Moves window forward expiring buckets older than time.
+    //! @param time the latest moment window includes.
+    //!
+    void advance(time_point time) noexcept
+    {
+        int64_t const index = bucket_index(time);
+        if (index > m_head)
+            advance_to(index);
+    }
+
+    //!
+    //! Removes all events.
+    //!
+    void clear() noexcept
+    {
+        for (auto& b : m_buckets)
+            clear(b);
+        m_events = 0;
+        m_totals = {};
+    }
+
+    //! @}
+    //! @name Queries
+    //! @{
+
+    //!
+    //! Get the window duration.
+    //!
+    duration span() const noexcept
+    {
+        return m_width * Buckets;
+    }
+
+    //!
+    //! Get the number of events in window.
+    //!
+    uint64_t events() const noexcept
+    {
+        return m_events;
+    }
+
+    //!
+    //! Get the number of events in window having the specified flag set.
+    //! @param T flag type.
+    //!
+    template<typename T>
+    uint64_t count() const noexcept
+    {
+        return m_totals[flags_type::template index<T>()];
+    }
+
+    //!
+    //! Checks that at least one of specified flags was set in window.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    bool seen_any() const noexcept
+    {
+        bool res = false;
+        bool const _[] = {false, (res = res || count<T>() != 0)...};
+        (void)_;
+        return res;
+    }
+
+    //!
+    //! Checks that every specified flag was set in window, maybe by different events.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    bool seen_all() const noexcept
+    {
+        bool res = true;
+        bool const _[] = {true, (res = res && count<T>() != 0)...};
+        (void)_;
+        return res;
+    }
+
+    //!
+    //! Checks that every specified flag was set in every event of non-empty window.
+    //! @param T... flag types.
+    //!
+    template<typename... T>
+    bool always() const noexcept
+    {
+        bool res = m_events != 0;
+        bool const _[] = {true, (res = res && count<T>() == m_events)...};
+        (void)_;
+        return res;
+    }
+
+    //!
+    //! Returns flags set by at least one event in window.
+    //!
+    flags_type seen() const noexcept
+    {
+        flags_type res;
+        for (auto const& b : m_buckets)
+            res |= b.any;
+        return res;
+    }
+
+    //!
+    //! Returns flags set by every event in window, all flags if window is empty.
+    //!
+    flags_type always_set() const noexcept
+    {
+        flags_type res = ~flags_type{};
+        for (auto const& b : m_buckets)
+            res &= b.all;
+        return res;
+    }
+
+    //! @}
+
+private:
+
+    static constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+
+    struct bucket
+    {
+        uint64_t events;
+        flags_type any;
+        flags_type all;
+        std::array<uint64_t, sizeof...(Args)> counts;
+    };
+
+    static void clear(bucket& b) noexcept
+    {
+        b.events = 0;
+        b.any = flags_type{};
+        b.all = ~flags_type{};
+        b.counts = {};
+    }
+
+    int64_t bucket_index(time_point time) const noexcept
+    {
+        return int64_t(time.time_since_epoch() / m_width);
+    }
+
+    // Expires buckets up to index, each bucket is visited at most once
+    void advance_to(int64_t index) noexcept
+    {
+        if (index - m_head >= int64_t(Buckets)) {
+            clear();
+        }
+        else {
+            for (int64_t i = m_head + 1; i <= index; ++i) {
+                auto& b = m_buckets[size_t(i) % Buckets];
+                if (b.events == 0)
+                    continue;
+                m_events -= b.events;
+                for (size_t k = 0; k < sizeof...(Args); ++k)
+                    m_totals[k] -= b.counts[k];
+                clear(b);
+            }
+        }
+        m_head = index;
+        m_head_end = time_point(m_width * (index + 1));
+    }
+
+    duration m_width;
+    int64_t m_head;
+    time_point m_head_end;
+    uint64_t m_events;
+    std::array<uint64_t, sizeof...(Args)> m_totals;
+    std::array<bucket, Buckets> m_buckets;
+};
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,373 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_SHM_FLAGS_REGISTRY_HPP_
+#define _TFL_SHM_FLAGS_REGISTRY_HPP_
+
+#include "typed_flags.hpp"
+#include "flags_query.hpp"
+#include "detail/bits.hpp"
+#include "detail/posix_error.hpp"
+#include "detail/layout_hash.hpp"
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "Shared flags require lock-free 64-bit atomics"
+#endif
+
+namespace tfl
+{
+
+//!
+//! @brief Header at the start of shared flags registry.
+//!
+//! Header is followed by modification counters on their own cache line
+//! and by entries of words_per_entry 64-bit words. Bit i of flags storage
+//! is bit i % 64 of word i / 64 of the entry.
+//!
+struct shm_flags_header
+{
+    char magic[8];              //!< "TFLSHM" followed by zeros
+    uint32_t version;           //!< format version, currently 3
+    uint32_t flag_count;        //!< number of flag types
+    uint64_t layout_hash;       //!< hash of flag names in order, see flag_name
+    uint64_t entries;           //!< number of entries
+    uint32_t words_per_entry;   //!< number of words per entry
+    uint8_t reserved[28];
+};
+
+static_assert(sizeof(shm_flags_header) == 64, "Shared flags header must occupy 64 bytes");
+
+namespace detail
+{
+
+constexpr char shm_flags_magic[8] = {'T', 'F', 'L', 'S', 'H', 'M', 0, 0};
+constexpr uint32_t shm_flags_version = 3;
+
+//
+// Writers increment begin before and end after modification, readers
+// retry until no modification has started since the end value they saw.
+// Both counters are equal when registry is not being modified.
+//
+struct shm_generation
+{
+    std::atomic<uint64_t> begin;
+    std::atomic<uint64_t> end;
+    uint8_t padding[48];
+};
+
+static_assert(sizeof(shm_generation) == 64, "Shared flags counters must occupy 64 bytes");
+static_assert(sizeof(std::atomic<uint64_t>) == 8, "Shared flags words must be plain 64-bit words");
+
+//
+// Holds descriptor of shared memory object locked against concurrent initialization.
+//
+class shm_lock
+{
+public:
+
+    explicit shm_lock(int fd)
+        : m_fd(fd)
+    {
+        while (::flock(m_fd, LOCK_EX) != 0) {
+            if (errno != EINTR)
+                throw_errno("Can't lock shared flags");
+        }
+    }
+
+    shm_lock(shm_lock const&) = delete;
+    shm_lock& operator = (shm_lock const&) = delete;
+
+    ~shm_lock()
+    {
+        ::flock(m_fd, LOCK_UN);
+    }
+
+private:
+
+    int m_fd;
+};
+
+} // namespace detail
+
+template<typename Flags>
+class shm_flags_registry;
+
+//!
+//! @brief Array of flags in POSIX shared memory updated by several processes.
+//!
+//! Every entry is stored as 64-bit atomic words modified in place, so
+//! set(), reset() and test() are lock-free. Every modification advances
+//! generation(), readers detect changes by comparing it without system
+//! calls, and get() returns consistent value of entry spanning several words.
+//!
+//! A process dying in the middle of modification leaves the registry
+//! marked as being modified for good. Readers don't wait for it forever:
+//! get() gives up after max_get_retries attempts and reads every word
+//! separately, so entries spanning several words may combine words of
+//! different modifications from then on and get() of them gets slower.
+//! Entries of at most 64 flags are read by one load and aren't affected.
+//! Recreate the registry to restore consistent reads.
+//! @param Args... user defined types with flag_name specialized.
+//!
+template<typename... Args>
+class shm_flags_registry<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    static_assert(sizeof...(Args) > 0, "Shared flags require at least one flag");
+
+    //!
+    //! Number of attempts get() makes to read entry not being modified.
+    //!
+    static constexpr unsigned max_get_retries = 1000;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Opens shared memory object, creates it with all flags unset if it doesn't exist.
+    //! @param name shared memory object name, starting with '/'.
+    //! @param entries number of entries.
+    //! @throws std::system_error if object can't be opened or mapped.
+    //! @throws std::invalid_argument if existing object layout or size doesn't match.
+    //!
+    shm_flags_registry(char const* name, size_t entries)
+        : m_size(0), m_map(MAP_FAILED)
+    {
+        int const fd = ::shm_open(name, O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+            detail::throw_errno("Can't open shared flags");
+        try {
+            open(fd, entries, detail::layout_hash<Args...>());
+        }
+        catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    }
+
+    shm_flags_registry(shm_flags_registry const&) = delete;
+    shm_flags_registry& operator = (shm_flags_registry const&) = delete;
+
+    ~shm_flags_registry()
+    {
+        if (m_map != MAP_FAILED)
+            ::munmap(m_map, m_size);
+    }
+
+    //!
+    //! Removes shared memory object name, mapped registries stay valid.
+    //! @param name shared memory object name.
+    //! @returns true if object existed.
+    //!
+    static bool remove(char const* name) noexcept
+    {
+        return ::shm_unlink(name) == 0;
+    }
+
+    //! @}
+    //! @name Element access
+    //! @{
+
+    //!
+    //! Get the number of entries.
+    //!
+    size_t size() const noexcept
+    {
+        return size_t(header().entries);
+    }
+
+    //!
+    //! Get the number of completed modifications by all processes.
+    //!
+    uint64_t generation() const noexcept
+    {
+        return counters().end.load(std::memory_order_acquire);
+    }
+
+    //!
+    //! Returns the value of the specified flag in the entry.
+    //! @param T flag type.
+    //! @param entry entry index less than size().
+    //!
+    template<typename T>
+    bool test(size_t entry) const noexcept
+    {
+        constexpr size_t index = flags_type::template index<T>();
+        uint64_t const w = words(entry)[index / 64].load(std::memory_order_acquire);
+        return (w >> (index % 64)) & 1;
+    }
+
+    //!
+    //! Returns consistent value of the entry unless a modifying process died,
+    //! see class description.
+    //! @param entry entry index less than size().
+    //!
+    flags_type get(size_t entry) const noexcept
+    {
+        auto& c = counters();
+        auto const src = words(entry);
+        flags_type res;
+        uint8_t* const dst = detail::storage_access::data(res);
+        // Single word is consistent by itself
+        for (unsigned attempt = 0; word_count > 1 && attempt < max_get_retries; ++attempt) {
+            uint64_t const end = c.end.load(std::memory_order_acquire);
+            for (size_t w = 0; w < word_count; ++w)
+                detail::store_le(dst + w * 8, src[w].load(std::memory_order_relaxed), tail_bytes(w));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (c.begin.load(std::memory_order_relaxed) == end)
+                return res;
+            std::this_thread::yield();
+        }
+        for (size_t w = 0; w < word_count; ++w)
+            detail::store_le(dst + w * 8, src[w].load(std::memory_order_acquire), tail_bytes(w));
+        return res;
+    }
+
+    //! @}
+    //! @name Modifiers
+    //! @{
+
+    //!
+    //! Sets specified flags in the entry.
+    //! @param T... flag types.
+    //! @param entry entry index less than size().
+    //!
+    template<typename... T>
+    void set(size_t entry) noexcept
+    {
+        modify(entry, detail::flags_mask<flags_type, T...>(), [](std::atomic<uint64_t>& w, uint64_t m) {
+            if (m)
+                w.fetch_or(m, std::memory_order_relaxed);
+        });
+    }
+
+    //!
+    //! Unsets specified flags in the entry.
+    //! @param T... flag types.
+    //! @param entry entry index less than size().
+    //!
+    template<typename... T>
+    void reset(size_t entry) noexcept
+    {
+        modify(entry, detail::flags_mask<flags_type, T...>(), [](std::atomic<uint64_t>& w, uint64_t m) {
+            if (m)
+                w.fetch_and(~m, std::memory_order_relaxed);
+        });
+    }
+
+    //!
+    //! Replaces flags of the entry.
+    //! @param entry entry index less than size().
+    //! @param value new flags.
+    //!
+    void assign(size_t entry, flags_type const& value) noexcept
+    {
+        modify(entry, value, [](std::atomic<uint64_t>& w, uint64_t v) {
+            w.store(v, std::memory_order_relaxed);
+        });
+    }
+
+    //! @}
+
+private:
+
+    static constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+    static constexpr size_t word_count = (bytes + 7) / 8;
+
+    static constexpr size_t tail_bytes(size_t word) noexcept
+    {
+        return bytes - word * 8 < 8 ? bytes - word * 8 : 8;
+    }
+
+    void open(int fd, size_t entries, uint64_t layout)
+    {
+        detail::shm_lock lock(fd);
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+            detail::throw_errno("Can't stat shared flags");
+        size_t const size = sizeof(shm_flags_header) + sizeof(detail::shm_generation) + entries * word_count * 8;
+        bool const created = st.st_size == 0;
+        if (created) {
+            if (::ftruncate(fd, off_t(size)) != 0)
+                detail::throw_errno("Can't resize shared flags");
+        }
+        else if (size_t(st.st_size) < sizeof(shm_flags_header)) {
+            throw std::invalid_argument("Shared flags object is truncated");
+        }
+        m_size = created ? size : size_t(st.st_size);
+        m_map = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m_map == MAP_FAILED)
+            detail::throw_errno("Can't map shared flags");
+        auto& h = *static_cast<shm_flags_header*>(m_map);
+        if (created) {
+            // new object is zero filled
+            h.version = detail::shm_flags_version;
+            h.flag_count = sizeof...(Args);
+            h.layout_hash = layout;
+            h.entries = entries;
+            h.words_per_entry = uint32_t(word_count);
+            memcpy(h.magic, detail::shm_flags_magic, sizeof(h.magic));
+            return;
+        }
+        if (memcmp(h.magic, detail::shm_flags_magic, sizeof(h.magic)) != 0)
+            throw std::invalid_argument("Not a shared flags object");
+        if (h.version != detail::shm_flags_version)
+            throw std::invalid_argument("Unsupported shared flags version");
+        if (h.flag_count != sizeof...(Args) || h.layout_hash != layout || h.words_per_entry != word_count)
+            throw std::invalid_argument("Shared flags layout doesn't match flags type");
+        if (h.entries != entries || m_size < size)
+            throw std::invalid_argument("Shared flags size doesn't match");
+    }
+
+    template<typename Op>
+    void modify(size_t entry, flags_type const& value, Op op) noexcept
+    {
+        auto& c = counters();
+        auto const dst = words(entry);
+        uint8_t const* const src = detail::storage_access::data(value);
+        c.begin.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t w = 0; w < word_count; ++w)
+            op(dst[w], detail::load_le(src + w * 8, tail_bytes(w)));
+        c.end.fetch_add(1, std::memory_order_release);
+    }
+
+    shm_flags_header const& header() const noexcept
+    {
+        return *static_cast<shm_flags_header const*>(m_map);
+    }
+
+    detail::shm_generation& counters() const noexcept
+    {
+        return *reinterpret_cast<detail::shm_generation*>(static_cast<char*>(m_map) + sizeof(shm_flags_header));
+    }
+
+    std::atomic<uint64_t>* words(size_t entry) const noexcept
+    {
+        auto const base = static_cast<char*>(m_map) + sizeof(shm_flags_header) + sizeof(detail::shm_generation);
+        return reinterpret_cast<std::atomic<uint64_t>*>(base) + entry * word_count;
+    }
+
+    size_t m_size;
+    void* m_map;
+};
+
+} // namespace tfl
+
+#endif
@@ -0,0 +1,244 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#ifndef _TFL_SUBSET_INDEX_HPP_
+#define _TFL_SUBSET_INDEX_HPP_
+
+#include "typed_flags.hpp"
+#include "detail/bits.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace tfl
+{
+
+template<typename Flags>
+class subset_index;
+
+//!
+//! @brief Index of flag sets answering subset and superset queries.
+//!
+//! Sets are stored in a trie of their set flag indices in ascending order,
+//! sets sharing a prefix share a path. A subset query descends only into
+//! flags set in the query, a superset query skips subtrees which have
+//! passed a query flag without taking it, so both visit a small part of
+//! the trie when few sets match. Index is immutable.
+//! @param Args... user defined types.
+//!
+template<typename... Args>
+class subset_index<typed_flags<Args...>>
+{
+public:
+
+    typedef typed_flags<Args...> flags_type;
+
+    //! @name Creation
+    //! @{
+
+    //!
+    //! Builds index of sets.
+    //! @param data array of sets.
+    //! @param n number of sets.
+    //! @throws std::invalid_argument if there are 2^32 or more sets or set flags in total.
+    //!
+    subset_index(flags_type const* data, size_t n)
+    {
+        if (n >= size_t(UINT32_MAX))
+            throw std::invalid_argument("Too many sets for subset index");
+        // Flag indices of every set, sets are sorted by them lexicographically
+        std::vector<uint32_t> offsets(n + 1);
+        std::vector<uint32_t> items;
+        for (size_t i = 0; i < n; ++i) {
+            detail::for_each_set_bit(detail::storage_access::data(data[i]), bytes, [&](size_t k) {
+                items.push_back(uint32_t(k));
+            });
+            if (items.size() >= size_t(UINT32_MAX))
+                throw std::invalid_argument("Too many set flags for subset index");
+            offsets[i + 1] = uint32_t(items.size());
+        }
+        m_ids.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            m_ids[i] = uint32_t(i);
+        std::sort(m_ids.begin(), m_ids.end(), [&](uint32_t a, uint32_t b) {
+            return std::lexicographical_compare(items.begin() + offsets[a], items.begin() + offsets[a + 1],
+                                                items.begin() + offsets[b], items.begin() + offsets[b + 1]);
+        });
+        m_nodes.push_back(node{0, 0, 0, 0, 0, uint32_t(n)});
+        build(0, 0, 0, uint32_t(n), offsets, items);
+    }
+
+    //!
+    //! Builds index of sets.
+    //! @param sets sets to index.
+    //! @throws std::invalid_argument if there are 2^32 or more sets or set flags in total.
+    //!
+    explicit subset_index(std::vector<flags_type> const& sets)
+        : subset_index(sets.data(), sets.size())
+    {}
+
+    //! @}
+    //! @name Capacity
+    //! @{
+
+    //!
+    //! Get the number of indexed sets.
+    //!
+    size_t size() const noexcept
+    {
+        return m_ids.size();
+    }
+
+    //!
+    //! Get the number of bytes taken by index.
+    //!
+    size_t memory_usage() const noexcept
+    {
+        return m_nodes.size() * sizeof(node) + m_ids.size() * sizeof(uint32_t);
+    }
+
+    //! @}
+    //! @name Queries
+    //! @{
+
+    //!
+    //! Calls function for every indexed set contained in query, in unspecified order.
+    //! @param query flags which sets must not exceed.
+    //! @param fn function accepting position of set in source array.
+    //!
+    template<typename Fn>
+    void for_each_subset_of(flags_type const& query, Fn&& fn) const
+    {
+        visit_subsets(0, detail::storage_access::data(query), fn);
+    }
+
+    //!
+    //! Calls function for every indexed set containing query, in unspecified order.
+    //! @param query flags which sets must include.
+    //! @param fn function accepting position of set in source array.
+    //!
+    template<typename Fn>
+    void for_each_superset_of(flags_type const& query, Fn&& fn) const
+    {
+        std::array<uint32_t, sizeof...(Args) + 1> wanted;
+        size_t count = 0;
+        detail::for_each_set_bit(detail::storage_access::data(query), bytes, [&](size_t k) {
+            wanted[count++] = uint32_t(k);
+        });
+        visit_supersets(0, wanted.data(), wanted.data() + count, fn);
+    }
+
+    //!
+    //! Returns ascending positions of indexed sets contained in query.
+    //! @param query flags which sets must not exceed.
+    //!
+    std::vector<size_t> subsets_of(flags_type const& query) const
+    {
+        std::vector<size_t> res;
+        for_each_subset_of(query, [&](size_t i) { res.push_back(i); });
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    //!
+    //! Returns ascending positions of indexed sets containing query.
+    //! @param query flags which sets must include.
+    //!
+    std::vector<size_t> supersets_of(flags_type const& query) const
+    {
+        std::vector<size_t> res;
+        for_each_superset_of(query, [&](size_t i) { res.push_back(i); });
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    //! @}
+
+private:
+
+    static constexpr size_t bytes = detail::storage_access::bytes<flags_type>();
+
+    // Sets equal to the path of node occupy [first, terminal_end) of sorted
+    // positions, sets below it [first, subtree_end)
+    struct node
+    {
+        uint32_t flag;
+        uint32_t first_child;
+        uint32_t child_count;
+        uint32_t first;
+        uint32_t terminal_end;
+        uint32_t subtree_end;
+    };
+
+    // Creates children of node holding sorted positions [lo, hi) sharing depth flags
+    void build(uint32_t index, size_t depth, uint32_t lo, uint32_t hi,
+               std::vector<uint32_t> const& offsets, std::vector<uint32_t> const& items)
+    {
+        auto const length = [&](uint32_t pos) { return offsets[m_ids[pos] + 1] - offsets[m_ids[pos]]; };
+        auto const item = [&](uint32_t pos) { return items[offsets[m_ids[pos]] + depth]; };
+        uint32_t begin = lo;
+        while (begin < hi && length(begin) == depth)
+            ++begin;
+        m_nodes[index].first = lo;
+        m_nodes[index].terminal_end = begin;
+        m_nodes[index].subtree_end = hi;
+        uint32_t const first_child = uint32_t(m_nodes.size());
+        for (uint32_t pos = begin; pos < hi;) {
+            uint32_t const flag = item(pos);
+            uint32_t end = pos + 1;
+            while (end < hi && item(end) == flag)
+                ++end;
+            m_nodes.push_back(node{flag, 0, 0, pos, 0, end});
+            pos = end;
+        }
+        uint32_t const child_count = uint32_t(m_nodes.size()) - first_child;
+        m_nodes[index].first_child = first_child;
+        m_nodes[index].child_count = child_count;
+        for (uint32_t c = first_child; c < first_child + child_count; ++c)
+            build(c, depth + 1, m_nodes[c].first, m_nodes[c].subtree_end, offsets, items);
+    }
+
+    template<typename Fn>
+    void visit_subsets(uint32_t index, uint8_t const* query, Fn& fn) const
+    {
+        node const& n = m_nodes[index];
+        for (uint32_t pos = n.first; pos < n.terminal_end; ++pos)
+            fn(size_t(m_ids[pos]));
+        for (uint32_t c = n.first_child; c < n.first_child + n.child_count; ++c) {
+            uint32_t const flag = m_nodes[c].flag;
+            if ((query[flag / 8] >> (flag % 8)) & 1)
+                visit_subsets(c, query, fn);
+        }
+    }
+
+    // Flags of [wanted, last) are still missing on the path to node
+    template<typename Fn>
+    void visit_supersets(uint32_t index, uint32_t const* wanted, uint32_t const* last, Fn& fn) const
+    {
+        node const& n = m_nodes[index];
+        if (wanted == last) {
+            for (uint32_t pos = n.first; pos < n.subtree_end; ++pos)
+                fn(size_t(m_ids[pos]));
+            return;
+        }
+        // Paths are ascending, a child above the next wanted flag can't reach it
+        for (uint32_t c = n.first_child; c < n.first_child + n.child_count; ++c) {
+            uint32_t const flag = m_nodes[c].flag;
+            if (flag > *wanted)
+                break;
+            visit_supersets(c, flag == *wanted ? wanted + 1 : wanted, last, fn);
+        }
+    }
+
+    std::vector<node> m_nodes;
+    std::vector<uint32_t> m_ids;
+};
+
+} // namespace tfl
+
+#endif
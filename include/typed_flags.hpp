@@ -14,10 +14,16 @@
 #include "detail/meta14.hpp"
 #endif
 #include <functional>
+#include <type_traits>
 
 namespace tfl
 {
 
+namespace detail
+{
+struct storage_access;
+}
+
 //!
 //! @brief Single flag container.
 //!
@@ -58,6 +64,67 @@ public:
     //! @}
 };
 
+//!
+//! @brief Empty tag standing for flag type.
+//!
+//! Passed to visitors instead of values since flag types can be incomplete.
+//! @param T flag type.
+//!
+template<typename T>
+struct type_tag
+{
+    typedef T type;
+};
+
+//!
+//! @brief Kinds of typed accesses reported to flags_hook.
+//!
+enum class flag_op
+{
+    test,   //!< test<T>()
+    set,    //!< set<T...>() and set(flag<T>...)
+    reset,  //!< reset<T...>()
+    flip,   //!< flip<T...>()
+    query   //!< group queries none/any/all<T...>() and get(flag<T>&...)
+};
+
+//!
+//! @brief Compile-time hook notified about typed accesses to flags.
+//!
+//! Default hook does nothing and compiles down to nothing. Specialize it for
+//! a flags type before the first use of that type to observe accesses,
+//! e.g. with flags_profiler.
+//! @param Flags typed_flags type.
+//!
+template<typename Flags>
+struct flags_hook
+{
+    template<flag_op Op, typename... T>
+    static void on_access() noexcept
+    {}
+};
+
+//!
+//! @brief Persistent name of flag type.
+//!
+//! Stored flags (flags_file, shm_flags_registry) are checked against the
+//! names of their flags in order, so data written for other flags or for
+//! reordered ones is rejected. There is no default, specialize it for
+//! every flag type stored that way:
+//! @code
+//! namespace tfl {
+//! template<> struct flag_name<eats_meat> { static char const* value() noexcept { return "eats_meat"; } };
+//! }
+//! @endcode
+//! Renaming the type doesn't change stored data as long as the name is kept.
+//! @param T flag type.
+//!
+template<typename T>
+struct flag_name
+{
+    static_assert(sizeof(T*) == 0, "Specialize tfl::flag_name for flag types of stored flags");
+};
+
 #if __cplusplus > 201402L
 #include "detail/facet17.hpp"
 #else
@@ -72,6 +139,8 @@ public:
 //! @param Args... user defined types.
 //!
 //! @note Types can be incomplete.
+//! @note Flags are trivially copyable and have standard layout, so they
+//! can be copied with std::memcpy or converted with std::bit_cast.
 //!
 template<typename... Args>
 class typed_flags: 
@@ -83,6 +152,7 @@ class typed_flags:
     typedef detail::typed_flags_facet<this_type> facet_type;
 
     friend class detail::typed_flags_facet<this_type>;
+    friend struct detail::storage_access;
 
     static_assert(detail::is_unique<Args...>::value, "Flag types are not unique.");
 
@@ -110,17 +180,33 @@ public:
     //!
     //! Sets all flags to zero.
     //!
-    typed_flags() {};
+    typed_flags()
+    {
+        static_assert(std::is_trivially_copyable<this_type>::value,
+                      "Flags are not trivially copyable");
+        static_assert(std::is_standard_layout<this_type>::value,
+                      "Flags are not standard layout");
+    };
+    
+    //!
+    //! Leaves flags uninitialized.<br> Values are indeterminate until 
+    //! assigned, so arrays of flags can be allocated without zeroing pass.
+    //! @param tag tfl::uninitialized.
+    //!
+    explicit typed_flags(uninitialized_t tag) noexcept
+        : parent_type(tag)
+    {}
     
     //!
     //! Sets concrete flags to corresponding values.
+    //! Remaining flags are initialized to zeros.
     //! @param flag<T>... flag values.
     //!
     template<typename... T>
     explicit typed_flags(flag<T>... flags) noexcept
-    {
-        set(flags...);
-    }
+        : parent_type(std::array<size_t, sizeof...(T)>{{index<T>()...}},
+                      std::array<bool, sizeof...(T)>{{bool(flags)...}})
+    {}
     
     //!
     //! Loads flag values from integral number.<br> Least significant bit
@@ -160,6 +246,7 @@ public:
     template<typename T>
     bool test() const noexcept
     {
+        flags_hook<this_type>::template on_access<flag_op::test, T>();
         return this->get_bit(index<T>());
     }
         
@@ -317,6 +404,24 @@ public:
         return !this->is_equal(other);
     }
     
+    //!
+    //! Checks that every flag set here is set in other.
+    //! @param other flags to compare with.
+    //!
+    bool is_subset_of(this_type const& other) const noexcept
+    {
+        return this->is_subset(other);
+    }
+    
+    //!
+    //! Checks that every flag set in other is set here.
+    //! @param other flags to compare with.
+    //!
+    bool is_superset_of(this_type const& other) const noexcept
+    {
+        return other.is_subset(*this);
+    }
+    
     //! @}
     //! @name Bitwise member operators
     //! @{
@@ -376,6 +481,35 @@ typed_flags<Args...> operator ^ ( typed_flags<Args...> const& lhs, typed_flags<A
 
 //! @}
 
+namespace detail
+{
+
+//
+// Access to raw storage bytes of flags for bulk algorithms.
+//
+struct storage_access
+{
+    template<typename Flags>
+    static constexpr size_t bytes() noexcept
+    {
+        return flags_storage<Flags::size()>::bytes();
+    }
+
+    template<typename... Args>
+    static uint8_t const* data(typed_flags<Args...> const& flags) noexcept
+    {
+        return static_cast<flags_storage<sizeof...(Args)> const&>(flags).data();
+    }
+
+    template<typename... Args>
+    static uint8_t* data(typed_flags<Args...>& flags) noexcept
+    {
+        return static_cast<flags_storage<sizeof...(Args)>&>(flags).data();
+    }
+};
+
+} // namespace detail
+
 } // namespace tfl
 
 #endif
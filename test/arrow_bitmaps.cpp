@@ -0,0 +1,143 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/arrow_bitmaps.hpp"
+#include <cassert>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+std::mt19937 gen(17);
+
+template<size_t... I>
+void check_roundtrip(std::index_sequence<I...>)
+{
+    typedef typed_flags<fl<I>...> flags_type;
+    constexpr size_t flags = sizeof...(I);
+    for (size_t n : {0, 1, 9, 64, 100, 513, 2000}) {
+        std::vector<flags_type> records;
+        for (size_t r = 0; r < n; ++r) {
+            std::string bits;
+            for (size_t i = 0; i < flags; ++i)
+                bits += gen() % 2 ? '1' : '0';
+            records.emplace_back(bits.c_str());
+        }
+        flag_planes<flags_type> planes;
+        transpose_to_planes(records.data(), n, planes);
+        auto const bitmaps = to_arrow_bitmaps(planes);
+
+        // byte layout: LSB-first, aligned and zero padded
+        for (size_t k = 0; k < flags; ++k) {
+            auto const& b = bitmaps[k];
+            assert( b.length == n && b.offset == 0 );
+            assert( reinterpret_cast<uintptr_t>(b.data) % arrow_alignment == 0 );
+            for (size_t r = 0; r < n; ++r) {
+                bool const bit = (b.data[r / 8] >> (r % 8)) & 1;
+                assert( bit == (records[r].to_string()[flags - 1 - k] == '1') );
+                (void)bit;
+            }
+            for (size_t byte = (n + 7) / 8; byte < arrow_buffer_bytes(n); ++byte)
+                assert( b.data[byte] == 0 );
+            if (n % 8)
+                assert( (b.data[n / 8] >> (n % 8)) == 0 );
+        }
+
+        // import copies of bitmaps shifted by offset
+        for (size_t offset : {0, 3, 64, 71}) {
+            std::vector<std::vector<uint8_t>> buffers(flags, std::vector<uint8_t>((offset + n + 7) / 8 + 1, 0xA5));
+            std::array<arrow_bitmap, flags> shifted;
+            for (size_t k = 0; k < flags; ++k) {
+                for (size_t r = 0; r < n; ++r) {
+                    size_t const bit = offset + r;
+                    uint8_t const mask = uint8_t(1 << (bit % 8));
+                    if ((bitmaps[k].data[r / 8] >> (r % 8)) & 1)
+                        buffers[k][bit / 8] |= mask;
+                    else
+                        buffers[k][bit / 8] &= uint8_t(~mask);
+                }
+                // buffer ends right after the last value
+                buffers[k].resize((offset + n + 7) / 8);
+                shifted[k] = arrow_bitmap{buffers[k].data(), n, offset};
+            }
+            arrow_flags_view<flags_type> view(shifted);
+            assert( view.size() == n );
+            std::vector<flags_type> decoded(n);
+            view.decode_into(decoded.data());
+            assert( decoded == records );
+            for (size_t r = 0; r < n; r += 7)
+                assert( view.get(r) == records[r] );
+            auto const expected = std::count_if(records.begin(), records.end(), [](flags_type const& f) {
+                return f.template test<fl<0>>() || f.template test<fl<flags - 1>>();
+            });
+            assert( (view.template count<any_of<fl<0>, fl<flags - 1>>>()) == size_t(expected) );
+            (void)expected;
+        }
+    }
+}
+
+int main()
+{
+    {
+        std::vector<animal> animals{animal{"101"}, animal{"011"}, animal{"111"}, animal{"000"}, animal{"001"}};
+        flag_planes<animal> planes;
+        transpose_to_planes(animals.data(), animals.size(), planes);
+        auto const meat = to_arrow_bitmap<eats_meat>(planes);
+        auto const grass = to_arrow_bitmap<eats_grass>(planes);
+        auto const tail = to_arrow_bitmap<has_tail>(planes);
+        assert( meat.data[0] == 0x17 );
+        assert( grass.data[0] == 0x06 );
+        assert( tail.data[0] == 0x05 );
+        (void)meat; (void)grass; (void)tail;
+        assert( arrow_buffer_bytes(0) == 0 );
+        assert( arrow_buffer_bytes(1) == 64 );
+        assert( arrow_buffer_bytes(512) == 64 );
+        assert( arrow_buffer_bytes(513) == 128 );
+
+        // foreign buffers in index order
+        uint8_t const meat_bits[] = {0x17}, grass_bits[] = {0x06}, tail_bits[] = {0x05 << 2};
+        arrow_flags_view<animal> view({{{meat_bits, 5, 0}, {grass_bits, 5, 0}, {tail_bits, 5, 2}}});
+        assert( view.test<eats_meat>(2) );
+        assert( !view.test<eats_grass>(0) );
+        assert( view.test<has_tail>(2) );
+        assert( view.get(1) == animals[1] );
+        assert( view.count<all_of<eats_meat>>() == 4 );
+        assert( (view.count<all_of<eats_meat, has_tail>>()) == 2 );
+        assert( (view.count<any_of<eats_grass, has_tail>>()) == 3 );
+        assert( (view.count<none_of<eats_grass, has_tail>>()) == 2 );
+        assert( view.bitmap<has_tail>().offset == 2 );
+
+        arrow_flags_view<animal> planes_view(planes);
+        assert( planes_view.get(4) == animals[4] );
+
+        bool thrown = false;
+        try {
+            arrow_flags_view<animal> bad({{{meat_bits, 5, 0}, {grass_bits, 4, 0}, {tail_bits, 5, 0}}});
+        }
+        catch (std::invalid_argument const&) {
+            thrown = true;
+        }
+        assert( thrown );
+        (void)thrown;
+    }
+
+    check_roundtrip(std::make_index_sequence<1>{});
+    check_roundtrip(std::make_index_sequence<9>{});
+    check_roundtrip(std::make_index_sequence<70>{});
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/atomic_flags_array.hpp"
+#include <cassert>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+class visited;
+class queued;
+class eats_meat;
+class eats_grass;
+class has_tail;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef typed_flags<visited, queued> marks;
+
+template<typename Flags, typename First, typename Last>
+void check_layout(atomic_flags_layout layout)
+{
+    size_t const n = 1000;
+    atomic_flags_array<Flags> array(n, layout);
+    assert( array.size() == n );
+    assert( array.layout() == layout );
+    std::mt19937 gen(31);
+    std::vector<Flags> expected(n);
+    for (size_t r = 0; r < 3000; ++r) {
+        size_t const i = gen() % n;
+        switch (gen() % 3) {
+        case 0: {
+            Flags const prev = array.template fetch_set<First>(i);
+            assert( prev == expected[i] );
+            (void)prev;
+            expected[i].template set<First>();
+            break;
+        }
+        case 1: {
+            bool const prev = array.template test_and_set<Last>(i);
+            assert( prev == expected[i].template test<Last>() );
+            (void)prev;
+            expected[i].template set<Last>();
+            break;
+        }
+        default: {
+            Flags const prev = array.template fetch_reset<First, Last>(i);
+            assert( prev == expected[i] );
+            (void)prev;
+            expected[i].template reset<First, Last>();
+        }
+        }
+    }
+    size_t first = 0, last = 0;
+    for (size_t i = 0; i < n; ++i) {
+        assert( array.get(i) == expected[i] );
+        assert( array.template test<First>(i) == expected[i].template test<First>() );
+        first += expected[i].template test<First>();
+        last += expected[i].template test<Last>();
+    }
+    assert( array.template count<First>() == first );
+    assert( array.template count<Last>() == last );
+    std::vector<Flags> loaded(n - 5);
+    array.load(3, n - 5, loaded.data());
+    for (size_t i = 0; i < loaded.size(); ++i)
+        assert( loaded[i] == expected[i + 3] );
+    array.clear();
+    assert( array.template count<First>() == 0 && array.get(n - 1) == Flags{} );
+}
+
+template<size_t... I>
+void check_wide(std::index_sequence<I...>)
+{
+    typedef typed_flags<fl<I>...> flags_type;
+    typedef fl<sizeof...(I) - 1> last;
+    check_layout<flags_type, fl<0>, last>(atomic_flags_layout::dense);
+    check_layout<flags_type, fl<0>, last>(atomic_flags_layout::striped);
+}
+
+int main()
+{
+    atomic_flags_array<animal> animals(3);
+    assert( animals.get(0) == animal{} );
+    bool const was_set = animals.test_and_set<has_tail>(1);
+    bool const still_set = animals.test_and_set<has_tail>(1);
+    assert( !was_set && still_set );
+    animal const before_set = animals.fetch_set<eats_meat, eats_grass>(1);
+    assert( before_set == animal{"100"} );
+    assert( animals.get(1) == animal{"111"} );
+    assert( animals.get(0) == animal{} && animals.get(2) == animal{} );
+    animal const before_reset = animals.fetch_reset<has_tail>(1);
+    assert( before_reset == animal{"111"} );
+    (void)was_set; (void)still_set; (void)before_set; (void)before_reset;
+    assert( animals.get(1, std::memory_order_relaxed) == animal{"011"} );
+    assert( animals.count<eats_grass>() == 1 && animals.count<has_tail>() == 0 );
+
+    check_layout<animal, eats_meat, has_tail>(atomic_flags_layout::dense);
+    check_layout<animal, eats_meat, has_tail>(atomic_flags_layout::striped);
+    check_layout<marks, visited, queued>(atomic_flags_layout::striped);
+    check_wide(std::make_index_sequence<1>{});
+    check_wide(std::make_index_sequence<5>{});
+    check_wide(std::make_index_sequence<33>{});
+    check_wide(std::make_index_sequence<64>{});
+
+    // Every element is claimed by exactly one thread
+    for (auto layout : {atomic_flags_layout::dense, atomic_flags_layout::striped}) {
+        size_t const threads = 4, n = 100000;
+        atomic_flags_array<marks> array(n, layout);
+        std::vector<size_t> claimed(threads);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                for (size_t i = 0; i < n; ++i) {
+                    size_t const k = t % 2 ? n - 1 - i : i;
+                    if (!array.test_and_set<visited>(k))
+                        ++claimed[t];
+                    array.fetch_set<queued>(k, std::memory_order_relaxed);
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+        assert( claimed[0] + claimed[1] + claimed[2] + claimed[3] == n );
+        assert( array.count<visited>() == n && array.count<queued>() == n );
+    }
+    return 0;
+}
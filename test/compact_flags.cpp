@@ -0,0 +1,196 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/compact_flags.hpp"
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+template<size_t I>
+class fl;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+template<size_t N>
+using flags_of = decltype(make_flags(std::make_index_sequence<N>{}));
+
+template<typename Flags, size_t... I>
+void check_queries(Flags const& f, compact_flags_view<Flags> const& view, std::index_sequence<I...>)
+{
+    bool same = true;
+    bool const _[] = {true, (same = same && view.template test<fl<I>>() == f.template test<fl<I>>())...};
+    (void)_;
+    assert( same );
+    (void)same;
+    auto const str = f.to_string();
+    assert( view.count() == size_t(std::count(str.begin(), str.end(), '1')) );
+    assert( view.none() == f.none() );
+    assert( view.any() == f.any() );
+    assert( view.all() == f.all() );
+    constexpr size_t last = sizeof...(I) - 1;
+    constexpr size_t second = sizeof...(I) > 1 ? 1 : 0;
+    assert( (view.template all<fl<0>, fl<last>>() == f.template all<fl<0>, fl<last>>()) );
+    assert( (view.template any<fl<0>, fl<last / 2>>() == f.template any<fl<0>, fl<last / 2>>()) );
+    assert( (view.template none<fl<second>, fl<last>>() == f.template none<fl<second>, fl<last>>()) );
+    (void)last;
+    (void)second;
+}
+
+template<size_t N>
+void check_round_trip(flags_of<N> const& f)
+{
+    typedef flags_of<N> flags_type;
+    std::vector<uint8_t> out{0xAA};
+    size_t const len = encode_compact(f, out);
+    assert( out.size() == len + 1 );
+    assert( len <= sizeof(flags_type) + 1 );
+    compact_flags_view<flags_type> view(out.data() + 1, out.size() - 1);
+    assert( view.size() == len );
+    (void)len;
+    assert( view.decode() == f );
+    flags_type g(~0ull);
+    view.decode_into(g);
+    assert( g == f );
+    check_queries(f, view, std::make_index_sequence<N>{});
+}
+
+template<size_t N>
+void check_all(std::mt19937& gen)
+{
+    typedef flags_of<N> flags_type;
+    check_round_trip<N>(flags_type{});
+    check_round_trip<N>(~flags_type{});
+    for (size_t round = 0; round < 50; ++round) {
+        // sparse
+        std::string bits(N, '0');
+        for (size_t k = round % 10; k > 0; --k)
+            bits[gen() % N] = '1';
+        check_round_trip<N>(flags_type(bits.c_str()));
+        // runs
+        size_t const from = gen() % N;
+        size_t const to = from + gen() % (N - from);
+        std::fill(bits.begin() + from, bits.begin() + to, '1');
+        check_round_trip<N>(flags_type(bits.c_str()));
+        std::fill(bits.begin(), bits.end(), '1');
+        std::fill(bits.begin() + from, bits.begin() + to, '0');
+        check_round_trip<N>(flags_type(bits.c_str()));
+        // dense
+        for (auto& c : bits)
+            c = gen() % 2 ? '1' : '0';
+        check_round_trip<N>(flags_type(bits.c_str()));
+    }
+}
+
+int main()
+{
+    std::mt19937 gen(5);
+    check_all<1>(gen);
+    check_all<7>(gen);
+    check_all<8>(gen);
+    check_all<30>(gen);
+    check_all<64>(gen);
+    check_all<65>(gen);
+    check_all<130>(gen);
+
+    // few set flags of a wide set are stored as index gaps
+    typedef flags_of<130> wide;
+    wide w;
+    w.set<fl<3>, fl<40>, fl<41>, fl<129>>();
+    std::vector<uint8_t> out;
+    encode_compact(w, out);
+    assert( out.size() == 6 );
+    compact_flags_view<wide> view(out.data(), out.size());
+    assert( view.format() == compact_format::indices );
+    assert( view.test<fl<41>>() );
+    assert( !view.test<fl<42>>() );
+    assert( (view.all<fl<3>, fl<129>>()) );
+    assert( view.count() == 4 );
+
+    // long runs are stored as their lengths
+    wide r;
+    r.flip();
+    r.reset<fl<0>, fl<1>>();
+    out.clear();
+    encode_compact(r, out);
+    assert( out.size() == 3 );
+    compact_flags_view<wide> runs(out.data(), out.size());
+    assert( runs.format() == compact_format::runs );
+    assert( runs.count() == 128 );
+    assert( !runs.test<fl<1>>() );
+    assert( runs.test<fl<2>>() );
+    assert( runs.test<fl<129>>() );
+
+    animal a{"101"};
+    out.clear();
+    encode_compact(a, out);
+    encode_compact(~a, out);
+    assert( compact_flags_view<animal>(out.data(), out.size()).format() == compact_format::dense );
+    animal b;
+    size_t used = decode_compact(out.data(), out.size(), b);
+    assert( b == a );
+    used += decode_compact(out.data() + used, out.size() - used, b);
+    assert( used == out.size() );
+    assert( b == ~a );
+
+    uint8_t const malformed[][3] = {
+        {0, 0xF8, 0},    // padding bits set
+        {3, 0, 0},       // unknown format
+        {1, 1, 3},       // index out of range
+        {1, 2, 0},       // truncated
+        {2, 1, 4},       // run out of range
+        {2, 0x80, 0x80}  // truncated varint
+    };
+    for (auto const& m : malformed) {
+        try
+        {
+            compact_flags_view<animal>(m, sizeof(m));
+            assert( false );
+        }
+        catch (std::invalid_argument const&)
+        {
+        }
+    }
+    // gaps and lengths wrapping position around
+    std::vector<std::vector<uint8_t>> wrapping;
+    for (uint64_t big : {~uint64_t(0), ~uint64_t(0) - 9, uint64_t(1) << 63}) {
+        std::vector<uint8_t> runs_buf{2, 2, 50};
+        detail::put_varint(runs_buf, big);
+        wrapping.push_back(runs_buf);
+        std::vector<uint8_t> indices_buf{1, 2, 10};
+        detail::put_varint(indices_buf, big);
+        wrapping.push_back(indices_buf);
+    }
+    for (auto const& m : wrapping) {
+        try
+        {
+            compact_flags_view<flags_of<100>>(m.data(), m.size());
+            assert( false );
+        }
+        catch (std::invalid_argument const&)
+        {
+        }
+    }
+
+    try
+    {
+        compact_flags_view<animal>(out.data(), 1);
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/event_flags.hpp"
+#include <cassert>
+#include <thread>
+
+using namespace tfl;
+
+class ready;
+class configured;
+class shutdown;
+
+typedef event_flags<ready, configured, shutdown> stage_events;
+
+int main()
+{
+    using namespace std::chrono;
+
+    stage_events events;
+    assert( events.load().none() );
+    assert( !events.test<ready>() );
+    events.set<ready>();
+    assert( events.test<ready>() );
+    assert( (events.all<ready>()) );
+    assert( (!events.all<ready, configured>()) );
+    assert( (events.any<ready, configured>()) );
+    assert( events.load().to_string() == "001" );
+    events.reset<ready>();
+    assert( events.load().none() );
+    
+    stage_events preset{stage_events::flags_type{flag<shutdown>{1}}};
+    assert( preset.test<shutdown>() );
+    preset.wait_any<shutdown>();
+    preset.wait_any<ready, shutdown>();
+    
+    bool const all_timed_out = !events.wait_all_for<ready>(milliseconds(10));
+    bool const any_timed_out = !events.wait_any_until<ready, configured>(system_clock::now() + milliseconds(10));
+    assert( all_timed_out && any_timed_out );
+    (void)all_timed_out; (void)any_timed_out;
+    
+    std::thread all_waiter([&events] {
+        events.wait_all<ready, configured>();
+        assert( (events.all<ready, configured>()) );
+    });
+    std::thread any_waiter([&events] {
+        bool const woken = events.wait_any_for<configured, shutdown>(seconds(30));
+        assert( woken );
+        (void)woken;
+    });
+    std::thread pred_waiter([&events] {
+        auto flags = events.wait<ready, configured, shutdown>([](stage_events::flags_type f) {
+            return f.all<ready, configured>() || f.test<shutdown>();
+        });
+        assert( (flags.all<ready, configured>()) );
+        (void)flags;
+    });
+    std::this_thread::sleep_for(milliseconds(20));
+    events.set<ready>();
+    std::this_thread::sleep_for(milliseconds(20));
+    events.set<configured>();
+    all_waiter.join();
+    any_waiter.join();
+    pred_waiter.join();
+    
+    events.reset<ready, configured>();
+    std::thread timed_waiter([&events] {
+        bool const woken = events.wait_all_until<shutdown>(steady_clock::now() + seconds(30));
+        assert( woken );
+        (void)woken;
+    });
+    std::this_thread::sleep_for(milliseconds(20));
+    events.set<ready>();
+    events.set<shutdown>();
+    timed_waiter.join();
+    
+    return 0;
+}
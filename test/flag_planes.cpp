@@ -0,0 +1,95 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flag_planes.hpp"
+#include <cassert>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+std::mt19937 gen(5);
+
+template<size_t... I>
+void check_planes(std::index_sequence<I...>)
+{
+    typedef typed_flags<fl<I>...> flags_type;
+    constexpr size_t flags = sizeof...(I);
+    for (size_t n : {0, 1, 7, 63, 64, 65, 200, 1000}) {
+        std::vector<flags_type> records;
+        for (size_t r = 0; r < n; ++r) {
+            std::string bits;
+            for (size_t i = 0; i < flags; ++i)
+                bits += gen() % 3 == 0 ? '1' : '0';
+            records.emplace_back(bits.c_str());
+        }
+        flag_planes<flags_type> planes;
+        transpose_to_planes(records.data(), n, planes);
+        assert( planes.size() == n );
+        assert( planes.stride() % 8 == 0 );
+        // scalar path
+        for (size_t r = 0; r < n; ++r) {
+            auto const bits = records[r].to_string();
+            for (size_t i = 0; i < flags; ++i) {
+                bool const plane_bit = (planes.plane(i)[r / 64] >> (r % 64)) & 1;
+                assert( plane_bit == (bits[flags - 1 - i] == '1') );
+                (void)plane_bit;
+            }
+        }
+        // padding is zeroed
+        for (size_t i = 0; i < flags; ++i) {
+            for (size_t w = n / 64; w < planes.stride(); ++w) {
+                uint64_t const tail = n % 64 && w == n / 64 ? ~0ULL << (n % 64) : ~0ULL;
+                assert( (planes.plane(i)[w] & tail) == 0 );
+                (void)tail;
+            }
+            assert( reinterpret_cast<uintptr_t>(planes.plane(i)) % 64 == 0 );
+        }
+        std::vector<flags_type> restored(n, flags_type{"1"});
+        gather_from_planes(planes, restored.data());
+        assert( restored == records );
+    }
+}
+
+template<size_t... N>
+void check_all(std::index_sequence<N...>)
+{
+    auto _ = {0, (check_planes(std::make_index_sequence<N + 1>{}), 0)...};
+    (void)_;
+}
+
+int main()
+{
+    assert( detail::transpose8x8(0x0000000000000002ULL) == 0x0000000000000100ULL );
+    assert( detail::transpose8x8(0x8000000000000000ULL) == 0x8000000000000000ULL );
+    
+    std::vector<animal> zoo(100);
+    zoo[3].set<has_tail>();
+    zoo[70].set<has_tail, eats_meat>();
+    flag_planes<animal> planes;
+    transpose_to_planes(zoo.data(), zoo.size(), planes);
+    assert( planes.count<has_tail>() == 2 );
+    assert( planes.count<eats_meat>() == 1 );
+    assert( planes.count<eats_grass>() == 0 );
+    assert( planes.test<has_tail>(3) );
+    assert( !planes.test<eats_meat>(3) );
+    assert( planes.test<eats_meat>(70) );
+    assert( planes.plane<has_tail>()[1] == 1ULL << 6 );
+    
+    check_all(std::make_index_sequence<64>{});
+    
+    return 0;
+}
@@ -0,0 +1,96 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flag_rank_select.hpp"
+#include <cassert>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+std::mt19937 gen(11);
+
+void check_rank_select(size_t n)
+{
+    // dense, sparse and empty planes
+    std::vector<animal> animals(n);
+    for (auto& a : animals) {
+        if (gen() % 2)
+            a.set<eats_meat>();
+        if (gen() % 5000 == 0)
+            a.set<eats_grass>();
+    }
+    flag_planes<animal> planes;
+    transpose_to_planes(animals.data(), n, planes);
+    flag_rank_select<animal> index(planes);
+    assert( index.size() == n );
+
+    std::vector<size_t> meat, grass;
+    for (size_t r = 0; r < n; ++r) {
+        assert( index.rank<eats_meat>(r) == meat.size() );
+        assert( index.rank<eats_grass>(r) == grass.size() );
+        assert( index.rank<has_tail>(r) == 0 );
+        if (animals[r].test<eats_meat>())
+            meat.push_back(r);
+        if (animals[r].test<eats_grass>())
+            grass.push_back(r);
+    }
+    assert( index.rank<eats_meat>(n) == meat.size() );
+    assert( index.count<eats_meat>() == meat.size() );
+    assert( index.count<eats_grass>() == grass.size() );
+    assert( index.count<has_tail>() == 0 );
+
+    for (size_t k = 0; k < meat.size(); ++k)
+        assert( index.select<eats_meat>(k) == meat[k] );
+    for (size_t k = 0; k < grass.size(); ++k)
+        assert( index.select<eats_grass>(k) == grass[k] );
+    assert( index.select<eats_meat>(meat.size()) == n );
+    assert( index.select<eats_grass>(grass.size()) == n );
+    assert( index.select<has_tail>(0) == n );
+}
+
+int main()
+{
+    for (size_t w = 0; w < 4096; ++w) {
+        uint64_t v = (uint64_t(gen()) << 32 | gen()) & (uint64_t(gen()) << 32 | gen());
+        for (unsigned k = 0, c = detail::popcount64(v); k < c; ++k) {
+            unsigned const pos = detail::select64(v, k);
+            assert( (v >> pos) & 1 );
+            assert( detail::popcount64(v & ((uint64_t(2) << pos) - 1)) == k + 1 );
+            (void)pos;
+        }
+    }
+
+    for (size_t n : {0, 1, 63, 64, 511, 512, 513, 65536, 65537, 300000})
+        check_rank_select(n);
+
+    {
+        size_t const n = 1 << 21;
+        std::vector<animal> animals(n);
+        for (auto& a : animals)
+            a = animal(gen());
+        flag_planes<animal> planes;
+        transpose_to_planes(animals.data(), n, planes);
+        flag_rank_select<animal> index(planes);
+        size_t const plane_bytes = planes.stride() * sizeof(uint64_t) * animal::size();
+        assert( index.memory_usage() * 20 < plane_bytes );
+        (void)plane_bytes;
+        for (size_t k = 0; k < index.count<has_tail>(); k += 997) {
+            size_t const row = index.select<has_tail>(k);
+            assert( animals[row].test<has_tail>() );
+            assert( index.rank<has_tail>(row) == k );
+            (void)row;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flag_stats.hpp"
+#include <cassert>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+std::mt19937 gen(7);
+
+template<size_t... I>
+void check_stats(std::index_sequence<I...>)
+{
+    typedef typed_flags<fl<I>...> flags_type;
+    constexpr size_t flags = sizeof...(I);
+    for (size_t n : {0, 1, 63, 64, 1000, 1024, 1025, 5000}) {
+        std::vector<flags_type> records;
+        std::vector<std::string> bits(n);
+        for (size_t r = 0; r < n; ++r) {
+            for (size_t i = 0; i < flags; ++i)
+                bits[r] += gen() % (i % 4 + 2) == 0 ? '1' : '0';
+            records.emplace_back(bits[r].c_str());
+        }
+        std::vector<uint64_t> expected(flags * flags);
+        for (size_t r = 0; r < n; ++r)
+            for (size_t i = 0; i < flags; ++i)
+                for (size_t j = 0; j < flags; ++j)
+                    expected[i * flags + j] += bits[r][flags - 1 - i] == '1' && bits[r][flags - 1 - j] == '1';
+
+        flag_planes<flags_type> planes;
+        transpose_to_planes(records.data(), n, planes);
+
+        auto const counts = flag_frequencies(records.data(), n);
+        auto const plane_counts = flag_frequencies(planes);
+        assert( counts.records() == n && plane_counts.records() == n );
+        for (size_t i = 0; i < flags; ++i) {
+            assert( counts.count(i) == expected[i * flags + i] );
+            assert( plane_counts.count(i) == expected[i * flags + i] );
+        }
+        (void)counts; (void)plane_counts;
+
+        auto const matrix = co_occurrence(records.data(), n);
+        auto const plane_matrix = co_occurrence(planes);
+        assert( matrix.records() == n && plane_matrix.records() == n );
+        for (size_t i = 0; i < flags; ++i) {
+            for (size_t j = 0; j < flags; ++j) {
+                assert( matrix.count(i, j) == expected[i * flags + j] );
+                assert( plane_matrix.count(i, j) == expected[i * flags + j] );
+            }
+        }
+    }
+}
+
+int main()
+{
+    {
+        std::vector<animal> animals{
+            animal{"101"}, animal{"011"}, animal{"111"}, animal{"000"}, animal{"001"}
+        };
+        auto const counts = flag_frequencies(animals.data(), animals.size());
+        assert( counts.records() == 5 );
+        assert( counts.get<eats_meat>() == 4 );
+        assert( counts.get<eats_grass>() == 2 );
+        assert( counts.get<has_tail>() == 2 );
+        assert( counts.frequency<eats_meat>() == 0.8 );
+        (void)counts;
+
+        auto const matrix = co_occurrence(animals.data(), animals.size());
+        assert( matrix.size() == 3 );
+        assert( (matrix.get<eats_meat, eats_meat>() == 4) );
+        assert( (matrix.get<eats_meat, has_tail>() == 2) );
+        assert( (matrix.get<has_tail, eats_meat>() == 2) );
+        assert( (matrix.get<eats_grass, has_tail>() == 1) );
+        assert( (matrix.get<eats_meat, eats_grass>() == 2) );
+        assert( matrix.data()[0] == 4 );
+
+        assert( flag_frequencies(animals.data(), 0).get<eats_meat>() == 0 );
+    }
+
+    check_stats(std::make_index_sequence<1>{});
+    check_stats(std::make_index_sequence<3>{});
+    check_stats(std::make_index_sequence<20>{});
+    check_stats(std::make_index_sequence<70>{});
+
+    return 0;
+}
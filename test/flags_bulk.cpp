@@ -0,0 +1,123 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_bulk.hpp"
+#include <cassert>
+#include <random>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+template<size_t N>
+using flags_n = decltype(make_flags(std::make_index_sequence<N>{}));
+
+std::mt19937_64 gen(3);
+
+template<typename Flags>
+std::vector<Flags> random_flags(size_t n)
+{
+    std::vector<Flags> res;
+    for (size_t i = 0; i < n; ++i) {
+        std::string bits;
+        for (size_t k = 0; k < Flags::size(); ++k)
+            bits += gen() % 2 ? '1' : '0';
+        res.emplace_back(bits.c_str());
+    }
+    return res;
+}
+
+template<typename Pred, typename Flags, typename S, typename R>
+void check_update(std::vector<Flags> const& input)
+{
+    auto expected = input;
+    for (auto& f : expected) {
+        if (Pred::test(f)) {
+            f.template set<S>();
+            f.template reset<R>();
+        }
+    }
+    auto actual = input;
+    update_where<Pred>(actual.data(), actual.size(), set_flags<S>{}, reset_flags<R>{});
+    assert( actual == expected );
+    
+    expected = input;
+    for (auto& f : expected) {
+        if (Pred::test(f))
+            f.template reset<S, R>();
+    }
+    actual = input;
+    update_where<Pred>(actual.data(), actual.size(), reset_flags<S, R>{});
+    assert( actual == expected );
+}
+
+template<size_t N>
+void check()
+{
+    typedef flags_n<N> flags_type;
+    typedef fl<0> a;
+    typedef fl<N / 2> b;
+    typedef fl<N - 1> c;
+    for (size_t n : {0, 1, 3, 17, 64, 1001}) {
+        auto const x = random_flags<flags_type>(n + 1);
+        auto const y = random_flags<flags_type>(n + 1);
+        // misaligned destination and source
+        for (size_t shift : {0, 1}) {
+            auto r_or = x, r_and = x, r_xor = x;
+            bitwise_or(r_or.data() + shift, y.data() + 1 - shift, n);
+            bitwise_and(r_and.data() + shift, y.data() + 1 - shift, n);
+            bitwise_xor(r_xor.data() + shift, y.data() + 1 - shift, n);
+            for (size_t i = 0; i < n; ++i) {
+                assert( r_or[i + shift] == (x[i + shift] | y[i + 1 - shift]) );
+                assert( r_and[i + shift] == (x[i + shift] & y[i + 1 - shift]) );
+                assert( r_xor[i + shift] == (x[i + shift] ^ y[i + 1 - shift]) );
+            }
+            assert( r_or[n - n * shift] == x[n - n * shift] );
+        }
+        check_update<all_of<a, b>, flags_type, c, a>(x);
+        check_update<any_of<a, b>, flags_type, b, c>(x);
+        check_update<none_of<b>, flags_type, a, c>(x);
+        check_update<all_of<>, flags_type, a, c>(x);
+    }
+}
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+int main()
+{
+    std::vector<animal> zoo(5);
+    zoo[1].set<eats_meat>();
+    zoo[2].set<eats_grass>();
+    update_where<any_of<eats_meat, eats_grass>>(zoo.data(), zoo.size(), set_flags<has_tail>{});
+    assert( zoo[0].none() );
+    assert( zoo[1].to_string() == "101" );
+    assert( zoo[2].to_string() == "110" );
+    update_where<all_of<has_tail>>(zoo.data(), zoo.size(), set_flags<eats_meat>{}, reset_flags<eats_grass>{});
+    assert( zoo[1].to_string() == "101" );
+    assert( zoo[2].to_string() == "101" );
+    update_where<none_of<has_tail>>(zoo.data(), zoo.size(), set_flags<eats_meat, eats_grass, has_tail>{});
+    assert( zoo[0].all() );
+    
+    check<1>();
+    check<3>();
+    check<9>();
+    check<20>();
+    check<32>();
+    check<40>();
+    check<64>();
+    check<100>();
+    
+    return 0;
+}
@@ -0,0 +1,128 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_delta.hpp"
+#include <cassert>
+#include <random>
+#include <string>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef typed_flags<class w0, class w1, class w2, class w3, class w4, class w5, class w6, class w7,
+                    class w8, class w9, class w10, class w11, class w12, class w13, class w14,
+                    class w15, class w16, class w17, class w18, class w19> wide;
+
+struct collect
+{
+    std::string& names;
+    void operator()(type_tag<eats_meat>) { names += "meat "; }
+    void operator()(type_tag<eats_grass>) { names += "grass "; }
+    void operator()(type_tag<has_tail>) { names += "tail "; }
+};
+
+template<typename Flags>
+void check_stream(size_t n, size_t changes, std::mt19937& gen)
+{
+    std::vector<Flags> from(n), to(n);
+    for (auto& f : from)
+        f = Flags(gen());
+    to = from;
+    for (size_t i = 0; i < changes; ++i)
+        to[gen() % n] ^= Flags(gen());
+    
+    std::vector<uint8_t> stream;
+    encode_deltas(from.data(), to.data(), n, stream);
+    encode_deltas(to.data(), to.data(), n, stream);
+    auto replica = from;
+    size_t used = apply_deltas(stream.data(), stream.size(), replica.data(), n);
+    assert( replica == to );
+    used += apply_deltas(stream.data() + used, stream.size() - used, replica.data(), n);
+    assert( used == stream.size() );
+    assert( replica == to );
+}
+
+int main()
+{
+    animal wolf{"101"};
+    animal rabbit{"110"};
+    auto d = diff(wolf, rabbit);
+    assert( !d.empty() );
+    assert( d.count() == 2 );
+    assert( d.changed<eats_meat>() );
+    assert( d.changed<eats_grass>() );
+    assert( !d.changed<has_tail>() );
+    std::string names;
+    d.for_each_changed(collect{names});
+    assert( names == "meat grass " );
+    apply(wolf, d);
+    assert( wolf == rabbit );
+    assert( diff(wolf, rabbit).empty() );
+    assert( diff(wolf, rabbit) == flags_delta<animal>{} );
+    
+    wide w1, w2;
+    w2.set<class w3, class w19>();
+    size_t visited = 0;
+    diff(w1, w2).for_each_changed([&visited](auto tag) {
+        visited += wide::index<typename decltype(tag)::type>();
+    });
+    assert( visited == 22 );
+    
+    std::mt19937 gen(7);
+    for (size_t n : {1, 2, 7, 8, 9, 100, 1000}) {
+        check_stream<animal>(n, n / 10 + 1, gen);
+        check_stream<wide>(n, n / 10 + 1, gen);
+        check_stream<animal>(n, n * 2, gen);
+        check_stream<wide>(n, n * 2, gen);
+    }
+    
+    // size depends on changed bits rather than on table length
+    std::vector<wide> big(100000), changed(100000);
+    changed[500].set<class w7>();
+    changed[90000].set<class w1, class w2>();
+    std::vector<uint8_t> stream;
+    encode_deltas(big.data(), changed.data(), big.size(), stream);
+    assert( stream.size() < 16 );
+    apply_deltas(stream.data(), stream.size(), big.data(), big.size());
+    assert( big == changed );
+    
+    try
+    {
+        apply_deltas(stream.data(), stream.size() - 2, big.data(), big.size());
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+    try
+    {
+        apply_deltas(stream.data(), stream.size(), big.data(), 10);
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+    
+    // gap wrapping position around to a valid one is rejected
+    std::vector<uint8_t> wrapping;
+    for (uint64_t v : {uint64_t(1), uint64_t(1), uint64_t(4), uint64_t(3), UINT64_MAX - 3, uint64_t(0)})
+        detail::put_varint(wrapping, v);
+    std::vector<wide> one(1);
+    try
+    {
+        apply_deltas(wrapping.data(), wrapping.size(), one.data(), one.size());
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+    
+    return 0;
+}
@@ -0,0 +1,213 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_file.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+class has_horns;
+template<size_t N> class w;
+
+namespace tfl
+{
+template<> struct flag_name<eats_meat> { static char const* value() noexcept { return "eats_meat"; } };
+template<> struct flag_name<eats_grass> { static char const* value() noexcept { return "eats_grass"; } };
+template<> struct flag_name<has_tail> { static char const* value() noexcept { return "has_tail"; } };
+template<> struct flag_name<has_horns> { static char const* value() noexcept { return "has_horns"; } };
+
+template<size_t N>
+struct flag_name<w<N>>
+{
+    static char const* value()
+    {
+        static std::string const name = "w" + std::to_string(N);
+        return name.c_str();
+    }
+};
+}
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef typed_flags<has_tail, eats_meat, eats_grass> reordered;
+typedef typed_flags<eats_meat, eats_grass, has_horns> renamed;
+typedef typed_flags<w<0>, w<1>, w<2>, w<3>, w<4>, w<5>, w<6>, w<7>, w<8>, w<9>,
+                    w<10>, w<11>, w<12>, w<13>, w<14>, w<15>, w<16>, w<17>, w<18>, w<19>> wide;
+
+char const* const path = "flags_file_tester.bin";
+
+template<typename Pred, typename Flags>
+size_t brute_count(std::vector<Flags> const& records)
+{
+    size_t res = 0;
+    for (auto const& r : records)
+        res += Pred::test(r);
+    return res;
+}
+
+void check_animals(std::vector<animal> const& records)
+{
+    flags_file_reader<animal> file(path);
+    file.advise_sequential();
+    assert( file.size() == records.size() );
+    for (size_t i = 0; i < records.size(); ++i) {
+        assert( file.get(i) == records[i] );
+        assert( file.test<has_tail>(i) == records[i].test<has_tail>() );
+    }
+    assert( file.count<all_of<eats_meat>>() == brute_count<all_of<eats_meat>>(records) );
+    assert( (file.count<all_of<eats_meat, has_tail>>() == brute_count<all_of<eats_meat, has_tail>>(records)) );
+    assert( (file.count<any_of<eats_grass, has_tail>>() == brute_count<any_of<eats_grass, has_tail>>(records)) );
+    assert( (file.count<none_of<eats_meat, eats_grass>>() == brute_count<none_of<eats_meat, eats_grass>>(records)) );
+    assert( file.count<all_of<>>() == records.size() );
+    assert( file.count<any_of<>>() == 0 );
+    size_t split = 0;
+    for (size_t b = 0; b < file.block_count(); ++b)
+        split += file.count<all_of<eats_meat, has_tail>>(b, b + 1);
+    assert( (split == file.count<all_of<eats_meat, has_tail>>()) );
+}
+
+int main()
+{
+    std::remove(path);
+    std::mt19937 gen(11);
+    std::vector<animal> records;
+    {
+        flags_file_writer<animal> writer(path, 512);
+        assert( writer.block_rows() == 512 );
+        // odd sized appends cross words and blocks
+        for (size_t n : {1, 63, 2, 700, 100, 1}) {
+            std::vector<animal> chunk(n);
+            for (auto& c : chunk)
+                c = animal(gen());
+            writer.append(chunk.data(), chunk.size());
+            records.insert(records.end(), chunk.begin(), chunk.end());
+        }
+        writer.flush();
+        check_animals(records);
+    }
+    {
+        // reopening continues incomplete block, block size comes from file
+        flags_file_writer<animal> writer(path, 1024);
+        assert( writer.block_rows() == 512 );
+        assert( writer.size() == records.size() );
+        // uniform blocks are decided by summaries
+        for (size_t i = 0; i < 2000; ++i) {
+            animal const a = i < 1000 ? animal{"011"} : animal{"000"};
+            writer.append(a);
+            records.push_back(a);
+        }
+    }
+    check_animals(records);
+
+    // reader keeps the records present at opening while writer appends
+    std::remove(path);
+    {
+        std::vector<animal> first(100);
+        for (size_t i = 0; i < first.size(); ++i)
+            first[i] = animal(gen() & ~2u) | (i % 2 ? animal{"010"} : animal{});
+        flags_file_writer<animal> writer(path, 512);
+        writer.append(first.data(), first.size());
+        writer.flush();
+        flags_file_reader<animal> file(path);
+        // appended records bring summary of the first block to its size
+        std::vector<animal> more(200000, animal{"100"});
+        std::fill(more.begin(), more.begin() + 50, animal{"010"});
+        writer.append(more.data(), more.size());
+        writer.flush();
+        assert( file.size() == first.size() );
+        assert( file.block_count() == 1 );
+        for (size_t i = 0; i < first.size(); ++i)
+            assert( file.get(i) == first[i] );
+        assert( file.count<all_of<eats_grass>>() == brute_count<all_of<eats_grass>>(first) );
+        // summary of the incomplete block counts appended records too
+        assert( file.count<none_of<eats_grass>>() == brute_count<none_of<eats_grass>>(first) );
+        assert( (file.count<any_of<eats_grass, has_tail>>() == brute_count<any_of<eats_grass, has_tail>>(first)) );
+    }
+
+    std::remove(path);
+    {
+        std::vector<wide> rows(5000);
+        for (auto& x : rows)
+            x = wide(gen() & gen());
+        flags_file_writer<wide>(path, 1024).append(rows.data(), rows.size());
+        flags_file_reader<wide> file(path);
+        assert( file.size() == rows.size() );
+        assert( file.block_count() == 5 );
+        assert( file.block_size(4) == 904 );
+        for (size_t i = 0; i < rows.size(); ++i)
+            assert( file.get(i) == rows[i] );
+        size_t set = 0;
+        for (size_t b = 0; b < file.block_count(); ++b)
+            set += file.summary<w<17>>(b);
+        assert( set == brute_count<all_of<w<17>>>(rows) );
+        assert( (file.count<all_of<w<3>, w<17>>>() == brute_count<all_of<w<3>, w<17>>>(rows)) );
+        assert( (file.count<none_of<w<0>, w<19>>>() == brute_count<none_of<w<0>, w<19>>>(rows)) );
+    }
+
+    // flag count mismatch
+    try
+    {
+        flags_file_reader<animal> file(path);
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+    try
+    {
+        flags_file_writer<animal> writer(path);
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+
+    // flags of the same count are told apart by their names in order
+    std::remove(path);
+    flags_file_writer<animal>(path).append(animal{"011"});
+    try
+    {
+        flags_file_reader<reordered> file(path);
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+    try
+    {
+        flags_file_writer<reordered> writer(path);
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+    try
+    {
+        flags_file_reader<renamed> file(path);
+        assert( false );
+    }
+    catch (std::invalid_argument const&)
+    {
+    }
+    assert( flags_file_reader<animal>(path).get(0) == animal{"011"} );
+    std::remove(path);
+    try
+    {
+        flags_file_reader<animal> file(path);
+        assert( false );
+    }
+    catch (std::system_error const&)
+    {
+    }
+    return 0;
+}
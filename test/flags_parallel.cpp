@@ -0,0 +1,104 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_parallel.hpp"
+#include <cassert>
+#include <random>
+#include <stdexcept>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef typed_flags<class w0, class w1, class w2, class w3, class w4, class w5, class w6, class w7,
+                    class w8, class w9, class w10, class w11, class w12, class w13, class w14,
+                    class w15, class w16, class w17, class w18, class w19> wide;
+
+template<typename Pred, typename Flags>
+void check_query(std::vector<Flags> const& data, thread_pool& pool)
+{
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (Pred::test(data[i]))
+            expected.push_back(i);
+    }
+    assert( parallel_count<Pred>(data.data(), data.size(), pool) == expected.size() );
+    assert( parallel_filter<Pred>(data.data(), data.size(), pool) == expected );
+    (void)pool;
+}
+
+template<typename Flags>
+void check_reductions(std::vector<Flags> const& data, thread_pool& pool)
+{
+    Flags any, all = ~Flags{};
+    for (auto const& d : data) {
+        any |= d;
+        all &= d;
+    }
+    assert( parallel_reduce_or(data.data(), data.size(), pool) == any );
+    assert( parallel_reduce_and(data.data(), data.size(), pool) == all );
+    (void)pool;
+}
+
+int main()
+{
+    std::mt19937 gen(3);
+    thread_pool single(1), pair(2), many(5);
+    for (thread_pool* pool : {&single, &pair, &many}) {
+        for (size_t n : {0, 1, 100, 16384, 16385, 100000}) {
+            std::vector<animal> animals(n);
+            for (auto& a : animals)
+                a = animal(gen());
+            check_query<all_of<eats_meat, has_tail>>(animals, *pool);
+            check_query<any_of<eats_grass>>(animals, *pool);
+            check_query<none_of<eats_meat, eats_grass>>(animals, *pool);
+            check_reductions(animals, *pool);
+
+            auto const h = parallel_histogram<has_tail, eats_meat>(animals.data(), animals.size(), *pool);
+            std::array<size_t, 4> expected{};
+            for (auto const& a : animals)
+                ++expected[a.test<has_tail>() + 2 * a.test<eats_meat>()];
+            assert( h == expected );
+            (void)h;
+
+            std::vector<wide> w(n);
+            for (auto& x : w)
+                x = wide(gen() & gen() & gen());
+            check_query<all_of<class w1, class w19>>(w, *pool);
+            check_query<any_of<class w0, class w9, class w10>>(w, *pool);
+            check_reductions(w, *pool);
+            auto const hw = parallel_histogram<class w3, class w4, class w5>(w.data(), w.size(), *pool);
+            size_t total = 0;
+            for (auto c : hw)
+                total += c;
+            assert( total == n );
+        }
+    }
+
+    // the first exception of a task is passed to the caller
+    try
+    {
+        many.run(100, [](size_t task, size_t) {
+            if (task == 42)
+                throw std::runtime_error("task failed");
+        });
+        assert( false );
+    }
+    catch (std::runtime_error const&)
+    {
+    }
+    std::atomic<size_t> done{0};
+    many.run(1000, [&](size_t, size_t thread) {
+        assert( thread < many.size() );
+        (void)thread;
+        ++done;
+    });
+    assert( done == 1000 );
+    return 0;
+}
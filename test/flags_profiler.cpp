@@ -0,0 +1,82 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_profiler.hpp"
+#include <cassert>
+#include <sstream>
+#include <thread>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+namespace tfl
+{
+template<> struct flags_hook<animal>: flags_profiler<animal> {};
+}
+
+typedef flags_profiler<animal> profiler;
+
+int main()
+{
+    animal wolf;
+    wolf.set<eats_meat>();
+    wolf.set<eats_meat, has_tail>();
+    wolf.set(flag<eats_grass>{0});
+    assert( wolf.test<eats_meat>() );
+    assert( wolf.test<has_tail>() );
+    assert( !wolf.test<eats_grass>() );
+    wolf.reset<has_tail>();
+    wolf.flip<has_tail>();
+    assert( (wolf.all<eats_meat, has_tail>()) );
+    assert( (wolf.any<eats_grass>()) == false );
+    flag<eats_meat> f;
+    wolf.get(f);
+    wolf.set();
+    assert( wolf.all() );
+    
+    std::thread([] {
+        animal rabbit;
+        for (int i = 0; i < 10; ++i)
+            rabbit.set<eats_grass>();
+    }).join();
+    
+    auto hot = profiler::hottest();
+    assert( hot.size() == 3 );
+    assert( hot[0].index == animal::index<eats_grass>() );
+    assert( hot[0].count(flag_op::set) == 11 );
+    assert( hot[0].count(flag_op::test) == 1 );
+    assert( hot[0].count(flag_op::query) == 1 );
+    assert( hot[0].total() == 13 );
+    
+    auto meat = profiler::get<eats_meat>();
+    assert( meat.count(flag_op::set) == 2 );
+    assert( meat.count(flag_op::test) == 1 );
+    assert( meat.count(flag_op::query) == 2 );
+    assert( meat.total() == 5 );
+    (void)meat;
+    
+    auto tail = profiler::get<has_tail>();
+    assert( tail.count(flag_op::set) == 1 );
+    assert( tail.count(flag_op::reset) == 1 );
+    assert( tail.count(flag_op::flip) == 1 );
+    assert( tail.count(flag_op::test) == 1 );
+    assert( tail.count(flag_op::query) == 1 );
+    (void)tail;
+    
+    std::ostringstream os;
+    profiler::dump(os);
+    assert( os.str().find("1\t1\t11\t0\t0\t1\t13\n") != std::string::npos );
+    
+    profiler::reset();
+    assert( profiler::hottest()[0].total() == 0 );
+    
+    return 0;
+}
@@ -0,0 +1,125 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_similarity.hpp"
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+std::mt19937 gen(23);
+
+template<typename Metric, typename Flags, typename Mask>
+std::vector<similarity_match> brute_force(Flags const& query, std::vector<Flags> const& records, Mask const& mask, size_t k)
+{
+    std::vector<similarity_match> res;
+    auto const q = query.to_string(), m = mask.to_string();
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto const r = records[i].to_string();
+        similarity_match match{i, 0, 0};
+        for (size_t b = 0; b < r.size(); ++b) {
+            if (m[b] != '1')
+                continue;
+            match.common += q[b] == '1' && r[b] == '1';
+            match.differ += q[b] != r[b];
+        }
+        res.push_back(match);
+    }
+    std::sort(res.begin(), res.end(), [](similarity_match const& a, similarity_match const& b) {
+        return Metric::better(a, b);
+    });
+    res.resize(std::min(k, res.size()));
+    return res;
+}
+
+bool same(std::vector<similarity_match> const& a, std::vector<similarity_match> const& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](similarity_match const& x, similarity_match const& y) {
+        return x.index == y.index && x.common == y.common && x.differ == y.differ;
+    });
+}
+
+template<size_t... I>
+void check_top_k(std::index_sequence<I...>)
+{
+    typedef typed_flags<fl<I>...> flags_type;
+    constexpr size_t flags = sizeof...(I);
+    auto const random_flags = [] {
+        std::string bits;
+        for (size_t i = 0; i < flags; ++i)
+            bits += gen() % 3 == 0 ? '1' : '0';
+        return flags_type(bits.c_str());
+    };
+    for (size_t n : {0, 1, 2, 5, 33, 500}) {
+        std::vector<flags_type> records;
+        for (size_t r = 0; r < n; ++r)
+            records.push_back(random_flags());
+        auto const query = random_flags();
+        auto const all = ~flags_type{};
+        flags_type subset;
+        subset.template set<fl<0>, fl<flags / 2>, fl<flags - 1>>();
+        for (size_t k : {1, 3, 10, 1000}) {
+            assert( same(top_k_similar<hamming_metric>(query, records.data(), n, k), brute_force<hamming_metric>(query, records, all, k)) );
+            assert( same(top_k_similar<jaccard_metric>(query, records.data(), n, k), brute_force<jaccard_metric>(query, records, all, k)) );
+            assert( (same(top_k_similar<jaccard_metric, fl<0>, fl<flags / 2>, fl<flags - 1>>(query, records.data(), n, k),
+                          brute_force<jaccard_metric>(query, records, subset, k))) );
+            (void)k;
+        }
+        for (auto const& r : records) {
+            auto const expected = brute_force<hamming_metric>(query, std::vector<flags_type>{r}, all, 1)[0];
+            assert( hamming(query, r) == expected.differ );
+            assert( jaccard(query, r) == expected.jaccard() );
+            (void)expected;
+        }
+    }
+}
+
+int main()
+{
+    {
+        animal const a{"011"}, b{"110"}, none;
+        assert( hamming(a, b) == 2 );
+        assert( hamming(a, a) == 0 );
+        assert( (hamming<eats_grass>(a, b) == 0) );
+        assert( (hamming<eats_meat, has_tail>(a, b) == 2) );
+        assert( jaccard(a, b) == 1.0 / 3 );
+        assert( jaccard(none, none) == 1.0 );
+        assert( jaccard(a, none) == 0.0 );
+        assert( (jaccard<has_tail>(a, none) == 1.0) );
+
+        std::vector<animal> animals{animal{"000"}, animal{"111"}, animal{"011"}, animal{"001"}, animal{"011"}};
+        auto const top = top_k_similar<hamming_metric>(a, animals.data(), animals.size(), 3);
+        assert( top.size() == 3 );
+        assert( top[0].index == 2 && top[0].differ == 0 );
+        assert( top[1].index == 4 );
+        assert( top[2].index == 1 && top[2].differ == 1 );
+
+        auto const best = top_k_similar<jaccard_metric>(b, animals.data(), animals.size(), 2);
+        assert( best[0].index == 1 && best[0].jaccard() == 2.0 / 3 );
+        assert( best[1].index == 2 && best[1].jaccard() == 1.0 / 3 );
+
+        assert( top_k_similar<jaccard_metric>(b, animals.data(), animals.size(), 0).empty() );
+    }
+
+    check_top_k(std::make_index_sequence<3>{});
+    check_top_k(std::make_index_sequence<33>{});
+    check_top_k(std::make_index_sequence<70>{});
+    check_top_k(std::make_index_sequence<130>{});
+
+    return 0;
+}
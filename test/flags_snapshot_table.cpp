@@ -0,0 +1,94 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_snapshot_table.hpp"
+#include <cassert>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+class beta;
+class premium;
+class dark_mode;
+
+typedef typed_flags<beta, premium, dark_mode> features;
+typedef flags_snapshot_table<features, 16> feature_table;
+
+int main()
+{
+    feature_table table(100);
+    auto reader = table.make_reader();
+    {
+        auto snap = reader.acquire();
+        assert( snap.size() == 100 );
+        assert( snap[0].none() && snap[99].none() );
+    }
+    
+    auto old_snap = table.make_reader();
+    auto before = old_snap.acquire();
+    {
+        auto upd = table.begin_update();
+        upd.set<beta, premium>(1);
+        upd.set<dark_mode>(50);
+        upd.reset<premium>(1);
+        upd.assign(99, features{"101"});
+        assert( (upd[1].all<beta>()) );
+        auto snap = reader.acquire();
+        assert( snap[1].none() );
+        upd.commit();
+    }
+    {
+        auto snap = reader.acquire();
+        assert( snap.test<beta>(1) );
+        assert( !snap.test<premium>(1) );
+        assert( (snap.all<dark_mode>(50)) );
+        assert( (snap.any<beta, premium>(99)) );
+        assert( (snap.none<premium>(99)) );
+        assert( snap[99].to_string() == "101" );
+        assert( snap[2].none() );
+    }
+    assert( before[1].none() && before[50].none() && before[99].none() );
+    {
+        auto discarded = table.begin_update();
+        discarded.set<premium>(2);
+    }
+    {
+        auto snap = reader.acquire();
+        assert( snap[2].none() );
+    }
+    
+    // readers always observe pairs of rows updated in one batch
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&table, &done] {
+            auto r = table.make_reader();
+            while (!done.load()) {
+                auto snap = r.acquire();
+                for (size_t row = 0; row < 50; ++row)
+                    assert( snap.test<premium>(row) == snap.test<premium>(row + 50) );
+            }
+        });
+    }
+    for (size_t i = 0; i < 2000; ++i) {
+        auto upd = table.begin_update();
+        if (upd[i % 50].test<premium>()) {
+            upd.reset<premium>(i % 50);
+            upd.reset<premium>(i % 50 + 50);
+        }
+        else {
+            upd.set<premium>(i % 50);
+            upd.set<premium>(i % 50 + 50);
+        }
+        upd.commit();
+    }
+    done = true;
+    for (auto& t : readers)
+        t.join();
+    
+    return 0;
+}
@@ -0,0 +1,131 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_table.hpp"
+#include <cassert>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+typedef decltype(make_flags(std::make_index_sequence<20>{})) wide_flags;
+
+std::mt19937 gen(13);
+
+template<typename Pred1, typename Pred2, typename Flags>
+size_t scan(flags_table<Flags> const& table)
+{
+    size_t res = 0;
+    for (size_t r = 0; r < table.size(); ++r)
+        res += Pred1::test(table[r]) && Pred2::test(table[r]);
+    return res;
+}
+
+void check_counts(flags_table<animal> const& table)
+{
+    size_t meat = 0, grass = 0, tail = 0;
+    for (size_t r = 0; r < table.size(); ++r) {
+        meat += table.test<eats_meat>(r);
+        grass += table.test<eats_grass>(r);
+        tail += table.test<has_tail>(r);
+    }
+    assert( table.count<eats_meat>() == meat );
+    assert( table.count<eats_grass>() == grass );
+    assert( table.count<has_tail>() == tail );
+    assert( table.count_combination<>() == table.size() );
+    assert( (table.count_combination<all_of<eats_meat>, none_of<eats_grass>>() == scan<all_of<eats_meat>, none_of<eats_grass>>(table)) );
+    assert( (table.count_combination<any_of<eats_grass, has_tail>, all_of<eats_meat>>() == scan<any_of<eats_grass, has_tail>, all_of<eats_meat>>(table)) );
+    assert( (table.count_combination<none_of<eats_meat, eats_grass, has_tail>>() == scan<none_of<eats_meat, eats_grass, has_tail>, all_of<>>(table)) );
+}
+
+int main()
+{
+    {
+        flags_table<animal> table(4, 3);
+        assert( table.size() == 4 );
+        assert( table.count<eats_meat>() == 0 );
+        assert( (table.count_combination<none_of<eats_meat>>() == 4) );
+
+        table.set<eats_meat, has_tail>(0);
+        table.set<eats_meat>(1);
+        table.set<eats_meat>(1);
+        table.assign(2, animal{"110"});
+        assert( table.count<eats_meat>() == 2 );
+        assert( table.count<eats_grass>() == 1 );
+        assert( table.count<has_tail>() == 2 );
+        assert( (table.count_combination<all_of<eats_meat>, none_of<has_tail>>() == 1) );
+        assert( (table.count_combination<all_of<has_tail>, none_of<eats_meat>>() == 1) );
+
+        table.reset<eats_meat>(0);
+        table.reset<eats_grass>(0);
+        assert( table.count<eats_meat>() == 1 );
+        assert( table.test<has_tail>(0) );
+        check_counts(table);
+    }
+    {
+        std::vector<animal> rows(1000);
+        for (auto& r : rows)
+            r = animal(gen());
+        flags_table<animal> table(rows, 4);
+        check_counts(table);
+        for (size_t i = 0; i < 5000; ++i) {
+            size_t const row = gen() % table.size();
+            switch (gen() % 3) {
+            case 0: table.set<eats_grass>(row); break;
+            case 1: table.reset<eats_meat, has_tail>(row); break;
+            default: table.assign(row, animal(gen())); break;
+            }
+        }
+        check_counts(table);
+    }
+    {
+        // concurrent writers on disjoint rows
+        size_t const threads = 4, rows = 4096;
+        flags_table<animal> table(rows, 2);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&table, t] {
+                std::mt19937 g(static_cast<unsigned>(t));
+                for (size_t i = 0; i < 20000; ++i) {
+                    size_t const row = g() % (rows / threads) * threads + t;
+                    if (g() % 2)
+                        table.set<eats_meat>(row);
+                    else
+                        table.assign(row, animal(g()));
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+        check_counts(table);
+    }
+    {
+        // combinations are not counted for many flags
+        static_assert(!flags_table<wide_flags>::has_combinations, "");
+        flags_table<wide_flags> table(100);
+        table.set<fl<19>, fl<3>>(7);
+        table.set<fl<19>>(8);
+        assert( table.count<fl<19>>() == 2 );
+        assert( table.count<fl<3>>() == 1 );
+        table.reset<fl<19>>(7);
+        assert( table.count<fl<19>>() == 1 );
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_update_queue.hpp"
+#include <atomic>
+#include <cassert>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef flags_update_queue<std::string, animal> animal_queue;
+
+int main()
+{
+    typedef animal_queue::update update;
+    auto const u = update::of(set_flags<eats_meat, has_tail>{}, reset_flags<has_tail, eats_grass>{});
+    assert( u.set == animal{"001"} && u.clear == animal{"110"} );
+    assert( update::of(reset_flags<eats_meat>{}).set == animal{} );
+    animal value{"010"};
+    u.apply(value);
+    assert( value == animal{"001"} );
+    // Composition equals sequential application for every value
+    auto const a = update::of(set_flags<eats_meat>{}, reset_flags<eats_grass>{});
+    auto const b = update::of(set_flags<eats_grass>{}, reset_flags<eats_meat, has_tail>{});
+    for (unsigned v = 0; v < 8; ++v) {
+        animal x(v), y(v);
+        a.apply(x);
+        b.apply(x);
+        a.then(b).apply(y);
+        assert( x == y );
+    }
+
+    {
+        animal_queue queue(3);
+        auto p = queue.make_producer();
+        p.push("cat", set_flags<eats_meat, has_tail>{});
+        p.push("cow", set_flags<eats_grass>{});
+        p.push("cat", reset_flags<has_tail>{});
+        bool const pushed = p.try_push("cow", update::of(set_flags<has_tail>{}));
+        bool const overflowed = !p.try_push("dog", update::of(set_flags<has_tail>{}));
+        assert( pushed && overflowed );
+        std::map<std::string, animal> table;
+        size_t applies = 0;
+        size_t const taken = queue.drain([&](std::string const& key, update const& m) {
+            m.apply(table[key]);
+            ++applies;
+        });
+        assert( taken == 4 && applies == 2 );
+        assert( table["cat"] == animal{"001"} && table["cow"] == animal{"110"} );
+        size_t const taken_again = queue.drain([](std::string const&, update const&) { assert( false ); });
+        bool const pushed_again = p.try_push("dog", update::of(set_flags<has_tail>{}));
+        assert( taken_again == 0 && pushed_again );
+        (void)pushed; (void)overflowed; (void)taken; (void)applies; (void)taken_again; (void)pushed_again;
+    }
+
+    // Slots of destroyed producers are reused and their modifications delivered
+    {
+        flags_update_queue<int, animal> queue;
+        {
+            auto p = queue.make_producer();
+            p.push(1, set_flags<eats_meat>{});
+        }
+        auto p = queue.make_producer();
+        p.push(1, set_flags<eats_grass>{});
+        animal merged;
+        size_t const taken = queue.drain([&](int, flags_update_queue<int, animal>::update const& m) { m.apply(merged); });
+        assert( taken == 2 && merged == animal{"011"} );
+        (void)taken;
+    }
+
+    // Concurrent producers, every producer owns its keys so result is deterministic
+    {
+        size_t const threads = 4, events = 100000, keys = 64;
+        flags_update_queue<size_t, animal> queue(256);
+        std::vector<std::thread> workers;
+        std::atomic<size_t> done{0};
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                auto p = queue.make_producer();
+                for (size_t i = 0; i < events; ++i) {
+                    size_t const key = i % keys * threads + t;
+                    if (i % 3 == 0)
+                        p.push(key, set_flags<eats_meat, has_tail>{});
+                    else if (i % 3 == 1)
+                        p.push(key, set_flags<eats_grass>{}, reset_flags<has_tail>{});
+                    else
+                        p.push(key, reset_flags<eats_meat>{});
+                }
+                done.fetch_add(1);
+            });
+        }
+        std::vector<animal> table(keys * threads), expected(keys * threads);
+        size_t taken = 0;
+        auto const apply = [&](size_t key, flags_update_queue<size_t, animal>::update const& m) { m.apply(table[key]); };
+        while (done.load() < threads)
+            taken += queue.drain(apply);
+        for (auto& w : workers)
+            w.join();
+        taken += queue.drain(apply);
+        assert( taken == threads * events );
+        for (size_t t = 0; t < threads; ++t) {
+            for (size_t i = 0; i < events; ++i) {
+                auto& x = expected[i % keys * threads + t];
+                if (i % 3 == 0)
+                    x.set<eats_meat, has_tail>();
+                else if (i % 3 == 1)
+                    x.set<eats_grass>(), x.reset<has_tail>();
+                else
+                    x.reset<eats_meat>();
+            }
+        }
+        assert( table == expected );
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/flags_window.hpp"
+#include <cassert>
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <utility>
+
+using namespace tfl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef std::chrono::steady_clock::time_point time_point;
+typedef std::chrono::seconds seconds;
+
+time_point at(int s)
+{
+    return time_point(seconds(s));
+}
+
+int main()
+{
+    {
+        flags_window<animal, 4> window(seconds(10));
+        assert( window.span() == seconds(40) );
+        assert( window.events() == 0 );
+        assert( !window.seen_any<eats_meat>() );
+        assert( !window.always<eats_meat>() );
+
+        window.add(at(100), animal{"001"});
+        window.add(at(105), animal{"011"});
+        window.add(at(112), animal{"101"});
+        assert( window.events() == 3 );
+        assert( window.count<eats_meat>() == 3 );
+        assert( window.count<eats_grass>() == 1 );
+        assert( window.count<has_tail>() == 1 );
+        assert( (window.seen_any<eats_grass, has_tail>()) );
+        assert( (window.seen_all<eats_meat, eats_grass, has_tail>()) );
+        assert( window.always<eats_meat>() );
+        assert( (!window.always<eats_meat, has_tail>()) );
+        assert( window.seen() == animal{"111"} );
+        assert( window.always_set() == animal{"001"} );
+
+        // late event inside window, too late event outside it
+        window.add(at(101), animal{"000"});
+        window.add(at(60), animal{"111"});
+        assert( window.events() == 4 );
+        assert( !window.always<eats_meat>() );
+
+        // buckets 100 and 110 expire one by one
+        window.advance(at(139));
+        assert( window.events() == 4 );
+        window.advance(at(140));
+        assert( window.events() == 1 );
+        assert( window.count<eats_grass>() == 0 );
+        assert( (!window.seen_all<eats_meat, eats_grass>()) );
+        assert( window.seen() == animal{"101"} );
+        window.add(at(151), animal{"010"});
+        assert( window.events() == 1 );
+        assert( window.seen() == animal{"010"} );
+
+        // gap longer than window
+        window.add(at(1000), animal{"100"});
+        assert( window.events() == 1 );
+        assert( window.count<has_tail>() == 1 );
+        assert( window.count<eats_grass>() == 0 );
+
+        window.clear();
+        assert( window.events() == 0 );
+        assert( window.seen() == animal{} );
+    }
+    {
+        // against brute force over stored events
+        std::mt19937 gen(19);
+        flags_window<animal, 16> window(std::chrono::milliseconds(100));
+        std::deque<std::pair<int64_t, animal>> events;
+        int64_t now = 1000, head = 0;
+        for (size_t i = 0; i < 20000; ++i) {
+            now += gen() % 7;
+            int64_t const t = now - int64_t(gen() % 50);
+            animal const f(gen());
+            window.add(time_point(std::chrono::milliseconds(t)), f);
+            events.emplace_back(t, f);
+            head = std::max(head, t / 100);
+            uint64_t n = 0, meat = 0, tail = 0;
+            for (auto const& e : events) {
+                if (e.first / 100 > head - 16) {
+                    ++n;
+                    meat += e.second.test<eats_meat>();
+                    tail += e.second.test<has_tail>();
+                }
+            }
+            while (!events.empty() && events.front().first / 100 <= head - 16 - 1)
+                events.pop_front();
+            assert( window.events() == n );
+            assert( window.count<eats_meat>() == meat );
+            assert( window.count<has_tail>() == tail );
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/shm_flags_registry.hpp"
+#include <cassert>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+namespace tfl
+{
+template<> struct flag_name<eats_meat> { static char const* value() noexcept { return "eats_meat"; } };
+template<> struct flag_name<eats_grass> { static char const* value() noexcept { return "eats_grass"; } };
+template<> struct flag_name<has_tail> { static char const* value() noexcept { return "has_tail"; } };
+
+template<size_t I>
+struct flag_name<fl<I>>
+{
+    static char const* value()
+    {
+        static std::string const name = "fl" + std::to_string(I);
+        return name.c_str();
+    }
+};
+}
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+typedef typed_flags<eats_meat, has_tail, eats_grass> reordered;
+
+template<size_t... I>
+typed_flags<fl<I>...> make_flags(std::index_sequence<I...>);
+
+typedef decltype(make_flags(std::make_index_sequence<100>{})) wide_flags;
+
+int main()
+{
+    std::string const name = "/tfl_test_" + std::to_string(::getpid());
+    shm_flags_registry<animal>::remove(name.c_str());
+    {
+        shm_flags_registry<animal> registry(name.c_str(), 8);
+        assert( registry.size() == 8 );
+        assert( registry.generation() == 0 );
+        assert( !registry.test<eats_meat>(3) );
+
+        registry.set<eats_meat, has_tail>(3);
+        assert( registry.generation() == 1 );
+        assert( registry.test<eats_meat>(3) );
+        assert( !registry.test<eats_grass>(3) );
+        assert( registry.get(3) == animal{"101"} );
+        assert( registry.get(2) == animal{} );
+
+        // other process sees and modifies the same flags
+        pid_t const pid = ::fork();
+        if (pid == 0) {
+            shm_flags_registry<animal> other(name.c_str(), 8);
+            bool ok = other.test<has_tail>(3) && other.generation() == 1;
+            other.reset<has_tail>(3);
+            other.assign(7, animal{"110"});
+            ::_exit(ok ? 0 : 1);
+        }
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        assert( WIFEXITED(status) && WEXITSTATUS(status) == 0 );
+        assert( registry.generation() == 3 );
+        assert( registry.get(3) == animal{"001"} );
+        assert( registry.test<eats_grass>(7) );
+        assert( registry.test<has_tail>(7) );
+
+        // flag order and size are checked
+        bool thrown = false;
+        try {
+            shm_flags_registry<reordered> other(name.c_str(), 8);
+        }
+        catch (std::invalid_argument const&) {
+            thrown = true;
+        }
+        assert( thrown );
+        thrown = false;
+        try {
+            shm_flags_registry<animal> other(name.c_str(), 9);
+        }
+        catch (std::invalid_argument const&) {
+            thrown = true;
+        }
+        assert( thrown );
+        (void)thrown;
+    }
+    bool const removed = shm_flags_registry<animal>::remove(name.c_str());
+    bool const removed_again = shm_flags_registry<animal>::remove(name.c_str());
+    assert( removed && !removed_again );
+    (void)removed; (void)removed_again;
+
+    {
+        // entries spanning several words stay consistent for readers
+        shm_flags_registry<wide_flags>::remove(name.c_str());
+        shm_flags_registry<wide_flags> registry(name.c_str(), 2);
+        wide_flags const zeros, ones = ~wide_flags{};
+        std::thread writer([&] {
+            for (size_t i = 0; i < 20000; ++i)
+                registry.assign(1, i % 2 ? ones : zeros);
+        });
+        for (size_t i = 0; i < 20000; ++i) {
+            auto const value = registry.get(1);
+            assert( value == zeros || value == ones );
+            (void)value;
+        }
+        writer.join();
+        registry.set<fl<99>>(0);
+        registry.set<fl<0>>(0);
+        assert( registry.test<fl<99>>(0) && registry.test<fl<0>>(0) && !registry.test<fl<64>>(0) );
+        assert( registry.generation() == 20002 );
+
+        // process died after starting modification, readers don't wait for it
+        int const fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        assert( fd >= 0 );
+        void* const map = ::mmap(nullptr, 128, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        assert( map != MAP_FAILED );
+        auto& begin = *reinterpret_cast<std::atomic<uint64_t>*>(static_cast<char*>(map) + sizeof(shm_flags_header));
+        begin.fetch_add(1);
+        wide_flags expected;
+        expected.set<fl<0>, fl<99>>();
+        assert( registry.get(0) == expected );
+        registry.reset<fl<0>>(0);
+        expected.reset<fl<0>>();
+        assert( registry.get(0) == expected );
+        ::munmap(map, 128);
+        shm_flags_registry<wide_flags>::remove(name.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+//
+// MIT License
+// Copyright (c) 2017 Roman Orlov
+// See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT
+//
+
+#include "../include/subset_index.hpp"
+#include <cassert>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tfl;
+
+template<size_t I>
+class fl;
+
+class has_tail;
+class eats_meat;
+class eats_grass;
+
+typedef typed_flags<eats_meat, eats_grass, has_tail> animal;
+
+std::mt19937 gen(29);
+
+template<typename Flags>
+Flags random_flags(size_t one_in)
+{
+    std::string bits;
+    for (size_t i = 0; i < Flags::size(); ++i)
+        bits += gen() % one_in == 0 ? '1' : '0';
+    return Flags(bits.c_str());
+}
+
+template<size_t... I>
+void check_random(std::index_sequence<I...>)
+{
+    typedef typed_flags<fl<I>...> flags_type;
+    std::vector<flags_type> sets;
+    for (size_t i = 0; i < 3000; ++i)
+        sets.push_back(random_flags<flags_type>(i % 3 ? 16 : 4));
+    sets.push_back(flags_type{});
+    sets.push_back(sets[7]);
+    subset_index<flags_type> index(sets);
+    assert( index.size() == sets.size() );
+    for (size_t q = 0; q < 200; ++q) {
+        flags_type const query = q % 5 == 0 ? sets[q] : random_flags<flags_type>(q % 2 ? 2 : 12);
+        std::vector<size_t> subsets, supersets;
+        for (size_t i = 0; i < sets.size(); ++i) {
+            if ((sets[i] & query) == sets[i])
+                subsets.push_back(i);
+            if ((sets[i] & query) == query)
+                supersets.push_back(i);
+        }
+        assert( index.subsets_of(query) == subsets );
+        assert( index.supersets_of(query) == supersets );
+    }
+    assert( index.supersets_of(flags_type{}).size() == sets.size() );
+    assert( index.subsets_of(~flags_type{}).size() == sets.size() );
+}
+
+int main()
+{
+    animal const rules[] = {animal{"001"}, animal{"011"}, animal{"110"}, animal{"000"}, animal{"011"}};
+    subset_index<animal> index(rules, 5);
+    assert( index.size() == 5 );
+    assert( (index.subsets_of(animal{"011"}) == std::vector<size_t>{0, 1, 3, 4}) );
+    assert( (index.subsets_of(animal{"100"}) == std::vector<size_t>{3}) );
+    assert( (index.supersets_of(animal{"001"}) == std::vector<size_t>{0, 1, 4}) );
+    assert( (index.supersets_of(animal{"111"}).empty()) );
+    size_t visited = 0;
+    index.for_each_subset_of(animal{"111"}, [&](size_t) { ++visited; });
+    assert( visited == 5 );
+    assert( index.memory_usage() > 0 );
+
+    subset_index<animal> empty(std::vector<animal>{});
+    assert( empty.size() == 0 );
+    assert( empty.subsets_of(animal{"111"}).empty() );
+    assert( empty.supersets_of(animal{}).empty() );
+
+    check_random(std::make_index_sequence<9>{});
+    check_random(std::make_index_sequence<70>{});
+    check_random(std::make_index_sequence<130>{});
+    return 0;
+}
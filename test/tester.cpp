@@ -6,6 +6,12 @@
 
 #include "../include/typed_flags.hpp"
 #include <cassert>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#if __cplusplus > 201703L
+#include <bit>
+#endif
 
 using namespace tfl;
 
@@ -195,5 +201,47 @@ int main()
     assert( flags_9.to_integral<int>() == 257 );
     assert( flags_9.to_string() == "100000001" );
     
+    static_assert( std::is_trivially_copyable<animal>::value, "" );
+    static_assert( std::is_standard_layout<animal>::value, "" );
+    static_assert( std::is_trivially_copyable<decltype(flags_9)>::value, "" );
+    static_assert( std::is_standard_layout<decltype(flags_9)>::value, "" );
+    
+    alignas(animal) unsigned char raw[sizeof(animal)];
+    memset(raw, 0xFF, sizeof(raw));
+    animal* uninit = new (raw) animal{uninitialized};
+    *uninit = rabbit;
+    assert( *uninit == rabbit );
+    animal copied;
+    memcpy(&copied, uninit, sizeof(animal));
+    assert( copied == rabbit );
+#if defined(__cpp_lib_bit_cast)
+    assert( std::bit_cast<uint8_t>(rabbit) == 6 );
+    assert( std::bit_cast<animal>(uint8_t(6)) == rabbit );
+#endif
+    
+    assert( animal{"011"}.is_subset_of(animal{"111"}) );
+    assert( animal{"111"}.is_superset_of(animal{"011"}) );
+    assert( !animal{"101"}.is_subset_of(animal{"011"}) );
+    assert( animal{}.is_subset_of(animal{}) );
+    assert( empty.is_subset_of(empty) && empty.is_superset_of(empty) );
+    typed_flags<class g1, class g2, class g3, class g4, class g5, class g6, class g7, class g8, class g9,
+                class g10, class g11, class g12, class g13, class g14, class g15, class g16, class g17,
+                class g18, class g19, class g20, class g21, class g22, class g23, class g24, class g25,
+                class g26, class g27, class g28, class g29, class g30, class g31, class g32, class g33,
+                class g34, class g35, class g36, class g37, class g38, class g39, class g40, class g41,
+                class g42, class g43, class g44, class g45, class g46, class g47, class g48, class g49,
+                class g50, class g51, class g52, class g53, class g54, class g55, class g56, class g57,
+                class g58, class g59, class g60, class g61, class g62, class g63, class g64, class g65,
+                class g66, class g67, class g68, class g69, class g70> wide, wider;
+    wide.set<class g2, class g70>();
+    wider.set<class g2, class g9, class g70>();
+    assert( wide.is_subset_of(wider) && !wider.is_subset_of(wide) );
+    wide.set<class g65>();
+    assert( !wide.is_subset_of(wider) && !wider.is_superset_of(wide) );
+    
+    decltype(flags_9) flags_9_list{flag<class f9>{1}, flag<class f2>{1},
+                                   flag<class f1>{1}, flag<class f1>{0}};
+    assert( flags_9_list.to_string() == "100000010" );
+    
     return 0;
 }